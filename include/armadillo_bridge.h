@@ -0,0 +1,30 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_ARMADILLO_BRIDGE_H
+#define GRAPH_SDK_ARMADILLO_BRIDGE_H
+
+#include <armadillo>
+#include <utility>
+
+#include "../include/graph.h"
+
+namespace graph_sdk {
+
+// arma::sp_mat only stores compressed sparse columns, so column j holds
+// the in-edges of j. Armadillo cannot adopt foreign buffers; the
+// conversions build the column arrays straight from the in-edge CSR in one
+// O(E) pass.
+arma::sp_mat to_armadillo(const DirectedGraph& graph);
+arma::sp_mat to_armadillo(const DiWeightedGraph& graph);
+
+// L = D - W of the underlying undirected simple graph
+arma::sp_mat armadillo_laplacian(const DirectedGraph& graph);
+
+// Coordinates of every node from the eigenvectors of the `dimensions`
+// smallest non-trivial eigenvalues of the Laplacian, one row per node,
+// through eigs_sym; false when it does not converge.
+std::pair<bool, arma::mat> armadillo_spectral_embedding(
+    const DirectedGraph& graph, size_t dimensions = 2);
+
+}  // namespace graph_sdk
+#endif
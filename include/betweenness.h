@@ -0,0 +1,51 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_BETWEENNESS_H
+#define GRAPH_SDK_BETWEENNESS_H
+
+#include <vector>
+
+#include "../include/graph.h"
+#include "../include/parallel.h"
+
+namespace graph_sdk {
+
+// Betweenness of v: the sum over ordered pairs s != v != t of the share of
+// shortest s-t paths passing through v, directed and unnormalised. Computed
+// by Brandes' dependency accumulation, sources spread over the threads.
+
+// hop-count shortest paths
+std::vector<double> betweenness_centrality(
+    const DirectedGraph& graph,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+// weighted shortest paths by Dijkstra, weights must be positive
+std::vector<double> betweenness_centrality(
+    const DiWeightedGraph& graph,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+struct BetweennessEstimate {
+    std::vector<double> centrality{};
+    // sources sampled, node_num() when the exact values were computed
+    size_t samples{};
+    // with probability at least 1 - delta, for every node
+    // |centrality - exact| <= error * V * (V - 2)
+    double error{};
+};
+
+// Sources are sampled uniformly in doubling batches. After each batch an
+// empirical Bernstein bound is taken over every node and sampling stops
+// once it is at most epsilon; the Hoeffding sample size caps the batches.
+// The same seed gives the same estimate whatever the thread count.
+BetweennessEstimate approximate_betweenness(
+    const DirectedGraph& graph, double epsilon = 0.01, double delta = 0.1,
+    unsigned seed = 0,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+BetweennessEstimate approximate_betweenness(
+    const DiWeightedGraph& graph, double epsilon = 0.01, double delta = 0.1,
+    unsigned seed = 0,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+}  // namespace graph_sdk
+#endif
@@ -0,0 +1,76 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_BIT_MATRIX_H
+#define GRAPH_SDK_BIT_MATRIX_H
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace graph_sdk {
+
+// Dense rows of bits, each row padded to whole 64-bit words so that rows can
+// be combined word by word.
+class BitMatrix {
+   private:
+    std::vector<uint64_t> bits_{};
+    size_t rows_{};
+    size_t cols_{};
+    size_t words_{};
+
+   public:
+    BitMatrix() = default;
+    BitMatrix(size_t rows, size_t cols)
+        : bits_(rows * ((cols + 63) / 64), 0),
+          rows_(rows),
+          cols_(cols),
+          words_((cols + 63) / 64) {}
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t words() const { return words_; }
+
+    bool test(size_t r, size_t c) const {
+        assert(r < rows_ && c < cols_);
+        return (bits_[r * words_ + c / 64] >> (c % 64)) & 1;
+    }
+
+    void set(size_t r, size_t c) {
+        assert(r < rows_ && c < cols_);
+        bits_[r * words_ + c / 64] |= uint64_t{1} << (c % 64);
+    }
+
+    void reset(size_t r, size_t c) {
+        assert(r < rows_ && c < cols_);
+        bits_[r * words_ + c / 64] &= ~(uint64_t{1} << (c % 64));
+    }
+
+    uint64_t* row(size_t r) { return bits_.data() + r * words_; }
+    const uint64_t* row(size_t r) const { return bits_.data() + r * words_; }
+
+    // row r |= row s
+    void row_or(size_t r, size_t s) {
+        auto* dst = row(r);
+        const auto* src = row(s);
+        for (size_t w = 0; w < words_; ++w) dst[w] |= src[w];
+    }
+
+    size_t row_count(size_t r) const {
+        size_t n = 0;
+        for (size_t w = 0; w < words_; ++w)
+            n += static_cast<size_t>(__builtin_popcountll(row(r)[w]));
+        return n;
+    }
+
+    std::vector<size_t> row_elements(size_t r) const {
+        std::vector<size_t> result{};
+        for (size_t w = 0; w < words_; ++w) {
+            for (auto bits = row(r)[w]; bits != 0; bits &= bits - 1)
+                result.push_back(w * 64 + __builtin_ctzll(bits));
+        }
+        return result;
+    }
+};
+
+}  // namespace graph_sdk
+#endif
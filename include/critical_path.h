@@ -0,0 +1,79 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_CRITICAL_PATH_H
+#define GRAPH_SDK_CRITICAL_PATH_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../include/graph.h"
+
+namespace graph_sdk {
+
+// Longest paths on a DAG whose edge weights are durations. head(v) is the
+// earliest start of v and tail(v) the longest path from v to a sink, so the
+// latest start is makespan - tail(v). Both are kept per node, which lets a
+// duration change refresh only the descendants (head) and the ancestors
+// (tail) of the changed edge.
+class CriticalPath {
+   private:
+    // the DAG both ways, in ids as narrow as it allows
+    template <typename NodeId, typename EdgeId>
+    struct Topology {
+        CsrGraph<NodeId, EdgeId> forward{};
+        CsrGraph<NodeId, EdgeId> backward{};
+        // position of every forward edge in the backward arrays
+        std::vector<EdgeId> mirror{};
+    };
+    // only wide_ is filled when the graph exceeds uint32_t ids
+    Topology<uint32_t, uint32_t> narrow_{};
+    Topology<uint64_t, uint64_t> wide_{};
+    bool is_wide_{false};
+    std::vector<int64_t> forward_weight_{};
+    std::vector<int64_t> backward_weight_{};
+    std::vector<size_t> level_{};
+    std::vector<int64_t> head_{};
+    std::vector<int64_t> tail_{};
+    // max tree over head_, the root is the makespan
+    std::vector<int64_t> span_{};
+    bool is_dag_{false};
+
+    template <typename NodeId, typename EdgeId>
+    void build(Topology<NodeId, EdgeId>& topology,
+               const DiWeightedGraph& graph, const ExecutionPolicy& policy);
+    template <typename NodeId, typename EdgeId>
+    int64_t pull_head(const Topology<NodeId, EdgeId>& topology,
+                      size_t v) const;
+    template <typename NodeId, typename EdgeId>
+    int64_t pull_tail(const Topology<NodeId, EdgeId>& topology,
+                      size_t v) const;
+    template <typename NodeId, typename EdgeId>
+    std::vector<size_t> critical_path(
+        const Topology<NodeId, EdgeId>& topology) const;
+    template <typename NodeId, typename EdgeId>
+    bool update_weight(const Topology<NodeId, EdgeId>& topology, size_t u,
+                       size_t v, int weight);
+    void update_span(size_t v);
+
+   public:
+    CriticalPath() = default;
+    explicit CriticalPath(
+        const DiWeightedGraph& graph,
+        const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+    // false for a cyclic graph, the other queries are then meaningless
+    bool is_dag() const { return is_dag_; }
+    size_t node_num() const { return head_.size(); }
+    int64_t makespan() const { return span_.empty() ? 0 : span_[1]; }
+    int64_t earliest_start(size_t v) const { return head_[v]; }
+    int64_t latest_start(size_t v) const { return makespan() - tail_[v]; }
+    int64_t slack(size_t v) const { return latest_start(v) - head_[v]; }
+    // zero slack chain from a source to a sink, smallest ids first
+    std::vector<size_t> critical_path() const;
+
+    // new duration of the existing edge u -> v, false when there is none
+    bool update_weight(size_t u, size_t v, int weight);
+};
+
+}  // namespace graph_sdk
+#endif
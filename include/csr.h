@@ -0,0 +1,267 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_CSR_H
+#define GRAPH_SDK_CSR_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph_sdk {
+
+template <typename T>
+class Range {
+   private:
+    const T* begin_{};
+    const T* end_{};
+
+   public:
+    Range(const T* begin, const T* end) : begin_(begin), end_(end) {}
+    const T* begin() const { return begin_; }
+    const T* end() const { return end_; }
+    size_t size() const { return end_ - begin_; }
+    bool empty() const { return begin_ == end_; }
+    T operator[](size_t i) const { return begin_[i]; }
+};
+
+// Compressed sparse rows: out-neighbours of v are
+// targets[offsets[v] .. offsets[v + 1]), sorted ascending. NodeId bounds the
+// node count and EdgeId the edge count; uint32_t halves the memory traffic
+// of every scan compared with size_t, uint64_t serves the very large graphs.
+template <typename NodeId = uint32_t, typename EdgeId = uint32_t>
+class CsrGraph {
+    static_assert(std::is_integral<NodeId>::value &&
+                      std::is_integral<EdgeId>::value,
+                  "CsrGraph index types must be integral");
+
+   private:
+    std::vector<EdgeId> offsets_{0};
+    std::vector<NodeId> targets_{};
+
+   public:
+    using node_type = NodeId;
+    using edge_type = EdgeId;
+    static constexpr NodeId none = std::numeric_limits<NodeId>::max();
+
+    CsrGraph() = default;
+
+    // throws std::length_error when the ids would not fit, see fits()
+    explicit CsrGraph(const std::vector<std::set<size_t>>& adjacency) {
+        size_t edges = 0;
+        for (const auto& x : adjacency) edges += x.size();
+        if (!fits(adjacency.size(), edges))
+            throw std::length_error("CsrGraph: graph exceeds the index types");
+        offsets_.resize(adjacency.size() + 1);
+        targets_.reserve(edges);
+        offsets_[0] = 0;
+        for (size_t i = 0; i < adjacency.size(); ++i) {
+            for (auto x : adjacency[i]) targets_.push_back(NodeId(x));
+            offsets_[i + 1] = EdgeId(targets_.size());
+        }
+    }
+
+    CsrGraph(std::vector<EdgeId> offsets, std::vector<NodeId> targets)
+        : offsets_(std::move(offsets)), targets_(std::move(targets)) {
+        assert(!offsets_.empty() && offsets_.back() == targets_.size());
+    }
+
+    // a node count of V leaves `none` free as a sentinel
+    static bool fits(size_t V, size_t E) {
+        return V < size_t(std::numeric_limits<NodeId>::max()) &&
+               E <= size_t(std::numeric_limits<EdgeId>::max());
+    }
+
+    size_t node_num() const { return offsets_.size() - 1; }
+    size_t edge_num() const { return targets_.size(); }
+    size_t degree(size_t v) const { return offsets_[v + 1] - offsets_[v]; }
+
+    Range<NodeId> neighbours(size_t v) const {
+        return Range<NodeId>(targets_.data() + offsets_[v],
+                             targets_.data() + offsets_[v + 1]);
+    }
+
+    const std::vector<EdgeId>& offsets() const { return offsets_; }
+    const std::vector<NodeId>& targets() const { return targets_; }
+
+    // transpose by counting sort, rows stay sorted
+    CsrGraph reverse() const {
+        const auto V = node_num();
+        std::vector<EdgeId> offsets(V + 1, 0);
+        for (auto x : targets_) offsets[x + 1] += 1;
+        for (size_t i = 0; i < V; ++i) offsets[i + 1] += offsets[i];
+        std::vector<NodeId> targets(targets_.size());
+        std::vector<EdgeId> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < V; ++i) {
+            for (auto x : neighbours(i)) targets[fill[x]++] = NodeId(i);
+        }
+        return CsrGraph(std::move(offsets), std::move(targets));
+    }
+};
+
+using CsrGraph32 = CsrGraph<uint32_t, uint32_t>;
+using CsrGraph64 = CsrGraph<uint64_t, uint64_t>;
+
+// underlying undirected graph: u and v adjacent when u -> v or v -> u,
+// loops dropped, rows sorted
+template <typename NodeId, typename EdgeId>
+CsrGraph<NodeId, EdgeId> symmetrize(const CsrGraph<NodeId, EdgeId>& graph) {
+    const auto reverse = graph.reverse();
+    const auto V = graph.node_num();
+    std::vector<EdgeId> offsets(V + 1, 0);
+    std::vector<NodeId> targets{};
+    targets.reserve(2 * graph.edge_num());
+    for (size_t v = 0; v < V; ++v) {
+        auto out = graph.neighbours(v);
+        auto in = reverse.neighbours(v);
+        std::set_union(out.begin(), out.end(), in.begin(), in.end(),
+                       std::back_inserter(targets));
+        auto row = targets.begin() + offsets[v];
+        targets.erase(std::remove(row, targets.end(), NodeId(v)),
+                      targets.end());
+        offsets[v + 1] = EdgeId(targets.size());
+    }
+    // doubling the edges may overflow EdgeId, the offsets are then wrong
+    if (!CsrGraph<NodeId, EdgeId>::fits(V, targets.size()))
+        throw std::length_error("symmetrize: graph exceeds the index types");
+    return CsrGraph<NodeId, EdgeId>(std::move(offsets), std::move(targets));
+}
+
+// The algorithms below accept any graph exposing node_type, node_num() and
+// neighbours(v); scratch arrays use node_type so they shrink with it.
+
+template <class Graph>
+std::vector<typename Graph::node_type> depth_first_order(const Graph& graph) {
+    using NodeId = typename Graph::node_type;
+    using Iterator = decltype(graph.neighbours(0).begin());
+    const auto V = graph.node_num();
+    std::vector<NodeId> order{};
+    order.reserve(V);
+    std::vector<bool> visited(V, false);
+    std::vector<std::pair<NodeId, Iterator>> frames{};
+    for (size_t i = 0; i < V; ++i) {
+        if (visited[i]) continue;
+        visited[i] = true;
+        order.push_back(NodeId(i));
+        frames.emplace_back(NodeId(i), graph.neighbours(i).begin());
+        while (!frames.empty()) {
+            auto& [curr, it] = frames.back();
+            if (it == graph.neighbours(curr).end()) {
+                frames.pop_back();
+                continue;
+            }
+            auto x = *it++;
+            if (visited[x]) continue;
+            visited[x] = true;
+            order.push_back(NodeId(x));
+            frames.emplace_back(NodeId(x), graph.neighbours(x).begin());
+        }
+    }
+    return order;
+}
+
+// hop distances from source, unreached nodes hold max(node_type)
+template <class Graph>
+std::vector<typename Graph::node_type> breadth_first_distances(
+    const Graph& graph, size_t source) {
+    using NodeId = typename Graph::node_type;
+    constexpr auto unreached = std::numeric_limits<NodeId>::max();
+    std::vector<NodeId> distance(graph.node_num(), unreached);
+    std::vector<NodeId> queue{NodeId(source)};
+    distance[source] = 0;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        auto curr = queue[head];
+        for (auto x : graph.neighbours(curr)) {
+            if (distance[x] != unreached) continue;
+            distance[x] = distance[curr] + 1;
+            queue.push_back(NodeId(x));
+        }
+    }
+    return distance;
+}
+
+// false when the graph is cyclic, order is then empty
+template <class Graph>
+bool topological_order(const Graph& graph,
+                       std::vector<typename Graph::node_type>& order) {
+    using NodeId = typename Graph::node_type;
+    const auto V = graph.node_num();
+    std::vector<NodeId> in_degree(V, 0);
+    for (size_t i = 0; i < V; ++i) {
+        for (auto x : graph.neighbours(i)) in_degree[x] += 1;
+    }
+    order.clear();
+    order.reserve(V);
+    for (size_t i = 0; i < V; ++i) {
+        if (in_degree[i] == 0) order.push_back(NodeId(i));
+    }
+    for (size_t head = 0; head < order.size(); ++head) {
+        for (auto x : graph.neighbours(order[head])) {
+            if (--in_degree[x] == 0) order.push_back(NodeId(x));
+        }
+    }
+    if (order.size() == V) return true;
+    order.clear();
+    return false;
+}
+
+// Tarjan, every component labelled by its smallest node id
+template <class Graph>
+bool strongly_connected_components(
+    const Graph& graph, std::vector<typename Graph::node_type>& scc) {
+    using NodeId = typename Graph::node_type;
+    using Iterator = decltype(graph.neighbours(0).begin());
+    constexpr auto unassigned = std::numeric_limits<NodeId>::max();
+    const auto V = graph.node_num();
+    scc.assign(V, unassigned);
+    std::vector<NodeId> index(V, 0), low(V, 0), visiting{};
+    std::vector<std::pair<NodeId, Iterator>> frames{};
+    NodeId counter = 0;
+    bool cyclic = false;
+
+    auto enter = [&](size_t x) {
+        index[x] = low[x] = ++counter;
+        visiting.push_back(NodeId(x));
+        frames.emplace_back(NodeId(x), graph.neighbours(x).begin());
+    };
+    for (size_t i = 0; i < V; ++i) {
+        if (index[i]) continue;
+        enter(i);
+        while (!frames.empty()) {
+            auto& [curr, it] = frames.back();
+            if (it != graph.neighbours(curr).end()) {
+                size_t x = *it++;
+                if (x == curr) cyclic = true;
+                if (index[x] == 0)
+                    enter(x);
+                else if (scc[x] == unassigned)
+                    low[curr] = std::min(low[curr], index[x]);
+                continue;
+            }
+            auto v = curr;
+            frames.pop_back();
+            if (!frames.empty()) {
+                auto parent = frames.back().first;
+                low[parent] = std::min(low[parent], low[v]);
+            }
+            if (low[v] != index[v]) continue;
+            auto first =
+                std::find(visiting.rbegin(), visiting.rend(), v).base() - 1;
+            if (visiting.end() - first > 1) cyclic = true;
+            auto label = *std::min_element(first, visiting.end());
+            std::for_each(first, visiting.end(),
+                          [&](const auto& x) { scc[x] = label; });
+            visiting.erase(first, visiting.end());
+        }
+    }
+    return cyclic;
+}
+
+}  // namespace graph_sdk
+#endif
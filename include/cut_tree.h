@@ -0,0 +1,54 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_CUT_TREE_H
+#define GRAPH_SDK_CUT_TREE_H
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <vector>
+
+namespace graph_sdk {
+
+// Flow-equivalent tree rooted at node 0: the min cut between u and v equals
+// the lightest edge on the tree path between them. Parents always have a
+// smaller id than their children, as Gusfield's construction produces.
+class CutTree {
+   private:
+    std::vector<size_t> parent_{};
+    std::vector<int> weight_{};
+    std::vector<size_t> depth_{};
+
+   public:
+    CutTree() = default;
+    CutTree(std::vector<size_t> parent, std::vector<int> weight)
+        : parent_(std::move(parent)),
+          weight_(std::move(weight)),
+          depth_(parent_.size(), 0) {
+        assert(parent_.size() == weight_.size());
+        for (size_t v = 1; v < parent_.size(); ++v) {
+            assert(parent_[v] < v);
+            depth_[v] = depth_[parent_[v]] + 1;
+        }
+    }
+
+    size_t node_num() const { return parent_.size(); }
+    // weight(v) is the cut value of the edge v - parent(v)
+    size_t parent(size_t v) const { return parent_[v]; }
+    int weight(size_t v) const { return weight_[v]; }
+
+    // O(path length), max(int) when u == v
+    int min_cut(size_t u, size_t v) const {
+        assert(u < parent_.size() && v < parent_.size());
+        int result = std::numeric_limits<int>::max();
+        while (u != v) {
+            if (depth_[u] < depth_[v]) std::swap(u, v);
+            result = std::min(result, weight_[u]);
+            u = parent_[u];
+        }
+        return result;
+    }
+};
+
+}  // namespace graph_sdk
+#endif
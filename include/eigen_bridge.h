@@ -0,0 +1,62 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_EIGEN_BRIDGE_H
+#define GRAPH_SDK_EIGEN_BRIDGE_H
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../include/csr.h"
+#include "../include/graph.h"
+
+namespace graph_sdk {
+
+// Eigen wants a signed storage index, hence int32_t rather than the
+// uint32_t of CsrGraph<>.
+using EigenCsr = Eigen::SparseMatrix<double, Eigen::RowMajor, int32_t>;
+using EigenCsc = Eigen::SparseMatrix<double, Eigen::ColMajor, int32_t>;
+
+// Adjacency kept in CsrGraph layout, which is exactly Eigen's compressed
+// row-major layout: matrix() maps the buffers without copying them, and
+// stays valid as long as the view does.
+class EigenAdjacency {
+   private:
+    CsrGraph<int32_t, int32_t> csr_{};
+    std::vector<double> values_{};
+
+   public:
+    using Map = Eigen::Map<const EigenCsr>;
+
+    // every edge holds 1
+    explicit EigenAdjacency(const DirectedGraph& graph);
+    // every edge holds its weight
+    explicit EigenAdjacency(const DiWeightedGraph& graph);
+
+    Map matrix() const {
+        auto V = Eigen::Index(csr_.node_num());
+        return Map(V, V, Eigen::Index(csr_.edge_num()), csr_.offsets().data(),
+                   csr_.targets().data(), values_.data());
+    }
+};
+
+// owning copies in one O(E) pass; the column-major form holds the same
+// entries, i.e. the in-edges of a node are its column
+EigenCsr to_eigen(const DirectedGraph& graph);
+EigenCsr to_eigen(const DiWeightedGraph& graph);
+EigenCsc to_eigen_csc(const DirectedGraph& graph);
+
+// L = D - W of the underlying undirected simple graph
+EigenCsc eigen_laplacian(const DirectedGraph& graph);
+
+// Coordinates of every node from the eigenvectors of the `dimensions`
+// smallest non-trivial eigenvalues of the Laplacian, one row per node.
+// Shift-invert subspace iteration over a sparse LDLT factorisation; false
+// when the factorisation fails or the iteration does not converge.
+std::pair<bool, Eigen::MatrixXd> eigen_spectral_embedding(
+    const DirectedGraph& graph, size_t dimensions = 2);
+
+}  // namespace graph_sdk
+#endif
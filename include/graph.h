@@ -4,13 +4,22 @@
 #define GRAPH_SDK_DIRECTEDGRAPH_H
 
 #include <algorithm>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <stack>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 
+#include "../include/bit_matrix.h"
+#include "../include/csr.h"
+#include "../include/cut_tree.h"
+#include "../include/matching.h"
 #include "../include/matrix.h"
+#include "../include/parallel.h"
+#include "../include/topological_levels.h"
+#include "../include/workspace.h"
 
 namespace graph_sdk {
 
@@ -48,45 +57,132 @@ using Adjacency = std::vector<std::set<size_t>>;
 
 enum class NodeAttribute { unlabelled, source, sink, source_sink, isolated };
 
+// degree: hub sort by total degree, rcm: reverse Cuthill-McKee,
+// gorder: greedy window ordering maximizing shared neighbours (Wei et al.)
+enum class Ordering { degree, rcm, gorder };
+
 struct Edge {
     size_t id;
     std::pair<size_t, size_t> arrow;
     int value;
 };
 
+class DirectedGraph;
+
+// Results derived from the adjacency of one graph version, built on first
+// use. Copies start empty, a copied graph never inherits the entries.
+struct DerivedCache {
+    std::mutex mutex{};
+    size_t version{0};
+    std::shared_ptr<const DirectedGraph> reverse{};
+    std::shared_ptr<const CsrGraph<>> reverse_csr{};
+    std::shared_ptr<const std::pair<bool, std::vector<size_t>>> scc{};
+    std::shared_ptr<const TopologicalLevels> levels{};
+    std::shared_ptr<const std::vector<NodeAttribute>> attribute{};
+    std::shared_ptr<const CsrGraph<>> csr{};
+    std::shared_ptr<const CsrGraph64> wide_csr{};
+    std::shared_ptr<const CsrGraph64> wide_reverse_csr{};
+    std::shared_ptr<const Matrix<size_t>> matrix{};
+
+    DerivedCache() = default;
+    DerivedCache(const DerivedCache&) {}
+    DerivedCache& operator=(const DerivedCache&) {
+        std::lock_guard<std::mutex> lock(mutex);
+        clear();
+        return *this;
+    }
+
+    void clear() {
+        reverse.reset();
+        reverse_csr.reset();
+        scc.reset();
+        levels.reset();
+        attribute.reset();
+        csr.reset();
+        wide_csr.reset();
+        wide_reverse_csr.reset();
+        matrix.reset();
+    }
+};
+
 class DirectedGraph {
-   private:
+   protected:
     Adjacency adjacency_{};
     size_t VN_{};
     size_t EN_{};
+    // bumped by every mutation, cache_ entries belong to one version
+    size_t version_{0};
+    mutable DerivedCache cache_{};
+
+    // The entry is built with the lock released, so a slow derivation does
+    // not block other lookups and may use the cache itself. Racing builders
+    // all return the first published entry; a result built for a version
+    // that changed meanwhile is returned but not kept.
+    template <class T, class Compute>
+    std::shared_ptr<const T> cached(std::shared_ptr<const T>& entry,
+                                    Compute&& compute) const {
+        size_t version = 0;
+        {
+            std::lock_guard<std::mutex> lock(cache_.mutex);
+            if (cache_.version != version_) {
+                cache_.clear();
+                cache_.version = version_;
+            }
+            if (entry) return entry;
+            version = version_;
+        }
+        auto built = std::make_shared<const T>(compute());
+        std::lock_guard<std::mutex> lock(cache_.mutex);
+        if (version != version_ || cache_.version != version) return built;
+        if (!entry) entry = std::move(built);
+        return entry;
+    }
 
     // helpers
-   //protected:
     void dfs_helper(size_t idx, std::vector<bool>& visited,
                     std::vector<size_t>& dfs_nodes) const;
 
     bool has_cycle_helper(size_t idx, std::vector<size_t>& visited) const;
     bool topo_sort_helper(size_t idx, std::stack<size_t>& visiting,
                           std::vector<size_t>& states) const;
-    bool extract_scc_helper(size_t i, std::vector<size_t>& visited,
-                            std::stack<size_t>& pseudo_topo,
+    bool extract_scc_helper(size_t i, size_t& counter,
+                            std::vector<size_t>& index,
+                            std::vector<size_t>& low,
+                            std::vector<size_t>& visiting,
                             std::vector<size_t>& scc) const;
+    std::vector<size_t> extract_scc_parallel(
+        const ExecutionPolicy& policy) const;
     void extract_sc_helper(size_t curr, std::vector<size_t>& chain,
                            std::vector<bool>& valid,
                            const std::vector<size_t>& scc,
                            std::vector<std::vector<size_t>>& cycles) const;
     void find_path_helper(size_t source, size_t sink, std::vector<size_t>& path,
                           std::vector<std::vector<size_t>>& paths) const;
+    bool bidirectional_search(Workspace& workspace, size_t source,
+                              size_t sink, std::vector<size_t>* path) const;
 
     std::vector<NodeAttribute> get_attribute() const;
+    std::vector<size_t> degree_order() const;
+    std::vector<size_t> rcm_order() const;
+    std::vector<size_t> gorder_order(size_t window) const;
 
    public:
     DirectedGraph() = default;
     explicit DirectedGraph(const size_t N);
     explicit DirectedGraph(const Edges&);
     explicit DirectedGraph(const Adjacency& adjacency)
-        : adjacency_(adjacency) {}
+        : adjacency_(adjacency),
+          VN_(adjacency.size()),
+          EN_(calculate_edge_num()) {}
     explicit DirectedGraph(const Matrix<size_t>& matrix);
+    template <typename NodeId, typename EdgeId>
+    explicit DirectedGraph(const CsrGraph<NodeId, EdgeId>& csr)
+        : adjacency_(csr.node_num()), VN_(csr.node_num()), EN_(csr.edge_num()) {
+        for (size_t i = 0; i < VN_; ++i) {
+            for (auto x : csr.neighbours(i))
+                adjacency_[i].insert(adjacency_[i].end(), x);
+        }
+    }
 
     // Basics
     void print_graph() const;
@@ -101,44 +197,127 @@ class DirectedGraph {
     Edges extract_edges() const;
     size_t calculate_edge_num() const;
     size_t fetch_edge_num() const;
+    std::vector<size_t> fetch_nodes(NodeAttribute attribute) const;
     DirectedGraph reverse_graph() const;
 
+    // Derived results computed once per version; a pointer taken earlier
+    // keeps describing the version it was built for.
+    size_t version() const { return version_; }
+    std::shared_ptr<const DirectedGraph> cached_reverse_graph() const;
+    // the policy only matters when the entry has to be built
+    std::shared_ptr<const std::pair<bool, std::vector<size_t>>> cached_scc(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
+    std::shared_ptr<const TopologicalLevels> cached_topological_levels(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
+    std::shared_ptr<const std::vector<NodeAttribute>> cached_attribute() const;
+    // both throw std::length_error unless fits_csr32()
+    std::shared_ptr<const CsrGraph<>> cached_csr() const;
+    // in-neighbours of v are the row v
+    std::shared_ptr<const CsrGraph<>> cached_reverse_csr() const;
+    // the same with uint64_t ids, for graphs too large for the above
+    std::shared_ptr<const CsrGraph64> cached_wide_csr() const;
+    std::shared_ptr<const CsrGraph64> cached_wide_reverse_csr() const;
+    bool fits_csr32() const { return CsrGraph32::fits(VN_, EN_); }
+    // visit(csr) on cached_csr(), or on cached_wide_csr() when the graph
+    // does not fit; both calls must return the same type
+    template <class Visit>
+    auto with_cached_csr(Visit&& visit) const {
+        if (fits_csr32()) return visit(*cached_csr());
+        return visit(*cached_wide_csr());
+    }
+    std::shared_ptr<const Matrix<size_t>> cached_matrix() const;
+    // compact view for the hot loops, see csr.h
+    template <typename NodeId = uint32_t, typename EdgeId = uint32_t>
+    CsrGraph<NodeId, EdgeId> to_csr() const {
+        return CsrGraph<NodeId, EdgeId>(adjacency_);
+    }
+
     // Modify
     void reset();
     void exchange_nodes(size_t n1, size_t n2);
 
+    // Reorder for locality; permutation[new_id] = old_id and
+    // inverse[old_id] = new_id.
+    std::vector<size_t> compute_ordering(Ordering ordering) const;
+    void relabel(const std::vector<size_t>& inverse);
+    std::pair<std::vector<size_t>, std::vector<size_t>> reorder(
+        Ordering ordering);
+
     // Random generate
     void random_generate(size_t V, size_t D);
     void random_generate_dag(size_t V, size_t D);
+    // reproducible for a given seed whatever the thread count
+    void random_generate(size_t V, size_t D, const ExecutionPolicy& policy,
+                         unsigned seed);
+    void random_generate_dag(size_t V, size_t D,
+                             const ExecutionPolicy& policy, unsigned seed);
     DirectedGraph generate_bipartite_dag() const;
     DirectedGraph graph_shuffle() const;
 
     // Algorithm
     std::vector<size_t> dfs() const;
     std::pair<bool, std::stack<size_t>> topological_sort() const;
+    // wavefronts of nodes whose predecessors are all on earlier levels
+    TopologicalLevels topological_levels(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
     bool has_cycle() const;
-    std::pair<bool, std::vector<size_t>> extract_scc() const;
+    // every component is labelled by its smallest node id
+    std::pair<bool, std::vector<size_t>> extract_scc(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
     DirectedGraph meta_graph() const;
-    std::vector<std::vector<size_t>> extract_simple_cycles() const;
+    std::vector<std::vector<size_t>> extract_simple_cycles(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
     std::vector<std::vector<size_t>> find_paths(size_t source,
                                                 size_t sink) const;
+    // Single pair queries by bidirectional breadth first search: the side
+    // with the smaller frontier expands a level, and the search stops at
+    // the first node both sides have reached. The path is a shortest one,
+    // empty when sink is unreachable.
+    bool is_reachable(size_t source, size_t sink) const;
+    std::vector<size_t> shortest_path(size_t source, size_t sink) const;
+    // maximum matching of sources to sinks, e.g. on generate_bipartite_dag,
+    // as (source, sink) pairs sorted by source
+    std::vector<std::pair<size_t, size_t>> bipartite_matching() const;
+
+    // DAG only, the flag is false when the graph has a cycle. Row v of the
+    // closure holds the descendants of v.
+    std::pair<bool, BitMatrix> transitive_closure(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
+    std::pair<bool, DirectedGraph> transitive_reduction(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
+
+    // Allocation free variants: scratch lives in the workspace and results
+    // go to caller vectors whose capacity is reused.
+    void dfs(Workspace& workspace, std::vector<size_t>& dfs_nodes) const;
+    bool has_cycle(Workspace& workspace) const;
+    bool topological_sort(Workspace& workspace,
+                          std::vector<size_t>& order) const;
+    bool extract_scc(Workspace& workspace, std::vector<size_t>& scc) const;
+    bool is_reachable(Workspace& workspace, size_t source,
+                      size_t sink) const;
+    bool shortest_path(Workspace& workspace, size_t source, size_t sink,
+                       std::vector<size_t>& path) const;
 };
 
 class DiWeightedGraph : public DirectedGraph {
    private:
-    Adjacency adjacency_{};
-    size_t VN_{};
-    size_t EN_{};
     WeightedEdges weighted_edges_{};
     void find_one_path_helper(
         size_t source, size_t sink,
         const std::vector<std::unordered_map<size_t, int>>& flow_adjacency,
-        std::vector<size_t>& path) const;
+        std::vector<size_t>& path, const ExecutionPolicy& policy) const;
     bool update_flow_graph(
         size_t source, size_t sink,
         std::vector<std::unordered_map<size_t, int>>& flow_adjacency,
-        int& flow_value) const;
+        int& flow_value, const ExecutionPolicy& policy) const;
     std::vector<std::unordered_map<size_t, int>> get_weighted_adjacency() const;
+    int saturate(size_t source, size_t sink,
+                 std::vector<std::unordered_map<size_t, int>>& flow_adjacency,
+                 const ExecutionPolicy& policy) const;
+    bool unit_bipartite(size_t source, size_t sink,
+                        std::vector<BipartiteSide>& side) const;
+    int residual_cut(size_t source, size_t sink, std::vector<char>& side,
+                     const ExecutionPolicy& policy) const;
 
    public:
     DiWeightedGraph() = default;
@@ -149,7 +328,27 @@ class DiWeightedGraph : public DirectedGraph {
     bool remove_node(size_t node);
     bool remove_edge(std::pair<size_t, size_t> arrow);
     bool is_positive_weighted() const;
-    int max_flow(size_t source, size_t sink) const;
+    int max_flow(size_t source, size_t sink,
+                 const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
+    const WeightedEdges& extract_weighted_edges() const;
+
+    // Min cut read off the final residual graph: the source side holds the
+    // nodes still reachable from source, the cut edges leave that side.
+    std::pair<int, std::vector<size_t>> min_cut_partition(
+        size_t source, size_t sink,
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
+    std::pair<int, std::vector<std::pair<size_t, size_t>>> min_cut(
+        size_t source, size_t sink,
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
+    // Gusfield's tree over the undirected capacities c(u, v) + c(v, u),
+    // V - 1 flow computations in total.
+    CutTree gomory_hu_tree(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
+
+    // Modify
+    void relabel(const std::vector<size_t>& inverse);
+    std::pair<std::vector<size_t>, std::vector<size_t>> reorder(
+        Ordering ordering);
 
 };
 
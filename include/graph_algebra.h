@@ -0,0 +1,41 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_GRAPH_ALGEBRA_H
+#define GRAPH_SDK_GRAPH_ALGEBRA_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../include/graph.h"
+#include "../include/parallel.h"
+
+namespace graph_sdk {
+
+// Graph algorithms written as semiring products, see sparse_matrix.h.
+
+// hop levels from source, max(size_t) when unreachable; push steps while
+// the frontier is small, pull steps over in-edges once it is large
+std::vector<size_t> algebraic_bfs(
+    const DirectedGraph& graph, size_t source,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+// (min, +) Bellman-Ford from source, max(int64_t) when unreachable; the
+// flag is false when a negative cycle is reachable
+std::pair<bool, std::vector<int64_t>> algebraic_sssp(
+    const DiWeightedGraph& graph, size_t source,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+// triangles of the underlying undirected simple graph, sum(L .* (L * L))
+uint64_t algebraic_triangle_count(
+    const DirectedGraph& graph,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+// power iteration, rank of sinks spread uniformly
+std::vector<double> algebraic_pagerank(
+    const DirectedGraph& graph, double damping = 0.85,
+    double tolerance = 1e-9, size_t max_iterations = 100,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+}  // namespace graph_sdk
+#endif
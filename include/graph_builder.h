@@ -0,0 +1,61 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_GRAPH_BUILDER_H
+#define GRAPH_SDK_GRAPH_BUILDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "../include/graph.h"
+
+namespace graph_sdk {
+
+// Edge ingestion from many threads at once. Vertex rows live in segments of
+// doubling size that are installed with a compare-and-swap, so the vertex
+// table grows without a lock and rows never move. A row append takes one of
+// a fixed set of striped locks, and edge events are counted in per-thread
+// shards. Rows are append only; duplicates are dropped by build(), which
+// must run after every producer has finished.
+class ConcurrentGraphBuilder {
+   private:
+    static constexpr size_t first_segment = 1024;
+    static constexpr size_t segment_num = 48;
+    static constexpr size_t stripe_num = 1024;
+    static constexpr size_t shard_num = 64;
+
+    struct alignas(64) Stripe {
+        std::mutex mutex{};
+    };
+    struct alignas(64) Shard {
+        std::atomic<size_t> count{0};
+    };
+
+    std::atomic<std::vector<size_t>*> segments_[segment_num]{};
+    std::unique_ptr<Stripe[]> stripes_{new Stripe[stripe_num]};
+    std::unique_ptr<Shard[]> shards_{new Shard[shard_num]};
+    std::atomic<size_t> node_num_{0};
+
+    std::vector<size_t>& row(size_t v);
+
+   public:
+    ConcurrentGraphBuilder() = default;
+    ~ConcurrentGraphBuilder();
+    ConcurrentGraphBuilder(const ConcurrentGraphBuilder&) = delete;
+    ConcurrentGraphBuilder& operator=(const ConcurrentGraphBuilder&) = delete;
+
+    // thread safe
+    void add_edge(std::pair<size_t, size_t> arrow);
+    size_t node_num() const { return node_num_.load(); }
+    // edge events so far, duplicates included
+    size_t event_num() const;
+
+    // single threaded: dedups the rows and returns the graph
+    DirectedGraph build(const ExecutionPolicy& policy = ExecutionPolicy::seq());
+};
+
+}  // namespace graph_sdk
+#endif
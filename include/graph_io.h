@@ -0,0 +1,67 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_GRAPH_IO_H
+#define GRAPH_SDK_GRAPH_IO_H
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+
+#include "../include/graph.h"
+#include "../include/parallel.h"
+
+namespace graph_sdk {
+
+// dot: `digraph`, one `u -> v;` line per edge and a `v;` line per node
+// without out-edges. graphml: one <node> element per node followed by its
+// <edge> elements, the weight as a <data key="weight"> child. json:
+// {"directed":true,"nodes":V,"edges":[[u,v],...]}, weighted edges as
+// [u,v,w], one edge per line.
+enum class GraphFormat { dot, graphml, json };
+
+// Rows are cut into blocks of about the same edge count; a round of blocks
+// is formatted in parallel into private buffers, which are then written in
+// order with one large write each and no flush. The output only depends on
+// the graph. False when the stream failed.
+bool write_graph(std::ostream& out, const DirectedGraph& graph,
+                 GraphFormat format,
+                 const ExecutionPolicy& policy = ExecutionPolicy::seq());
+bool write_graph(std::ostream& out, const DiWeightedGraph& graph,
+                 GraphFormat format,
+                 const ExecutionPolicy& policy = ExecutionPolicy::seq());
+bool write_graph(const std::string& path, const DirectedGraph& graph,
+                 GraphFormat format,
+                 const ExecutionPolicy& policy = ExecutionPolicy::seq());
+bool write_graph(const std::string& path, const DiWeightedGraph& graph,
+                 GraphFormat format,
+                 const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+// Uncompressed chunking: the document is split over path.0, path.1, ...,
+// a new part starting at the first block boundary after chunk_bytes. The
+// parts concatenate to the output of write_graph. Returns the number of
+// parts, 0 when a file could not be written.
+size_t write_graph_chunks(
+    const std::string& path, const DirectedGraph& graph, GraphFormat format,
+    size_t chunk_bytes,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+size_t write_graph_chunks(
+    const std::string& path, const DiWeightedGraph& graph, GraphFormat format,
+    size_t chunk_bytes,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+// Streaming readers for the layout the writers produce: one element per
+// line, read through a large buffer. Node ids are the integers written,
+// graphml ids may carry an `n` prefix. False on a malformed line; a
+// weighted read of an edge without weight gives it weight 1. DiWeightedGraph
+// only knows nodes that have an edge.
+std::pair<bool, DirectedGraph> read_graph(std::istream& in,
+                                          GraphFormat format);
+std::pair<bool, DiWeightedGraph> read_weighted_graph(std::istream& in,
+                                                     GraphFormat format);
+std::pair<bool, DirectedGraph> read_graph(const std::string& path,
+                                          GraphFormat format);
+std::pair<bool, DiWeightedGraph> read_weighted_graph(const std::string& path,
+                                                     GraphFormat format);
+
+}  // namespace graph_sdk
+#endif
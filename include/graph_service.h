@@ -0,0 +1,138 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_GRAPH_SERVICE_H
+#define GRAPH_SDK_GRAPH_SERVICE_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/graph.h"
+#include "../include/parallel.h"
+#include "../include/versioned_graph.h"
+
+namespace graph_sdk {
+
+// Binary protocol of the query service, every integer little endian.
+//   request: u32 size | u32 tag | u8 opcode | u64 argument...
+//   reply:   u32 size | u32 tag | u8 status | payload
+// `size` counts the bytes after itself. Requests may be pipelined; replies
+// carry the tag of their request and may arrive in any order.
+enum class Opcode : uint8_t {
+    ping = 0,               // () -> ()
+    reachable = 1,          // (u, v) -> u8
+    scc_id = 2,             // (v) -> u64 smallest node of the component
+    shortest_path = 3,      // (u, v) -> u32 n, u64 node...
+    topological_level = 4,  // (v) -> u64, no_result on or behind a cycle
+    max_flow = 5,           // (s, t) -> i64, unit capacities
+    certificate = 6,        // () -> u64 refinement_certificate
+    add_edge = 7,           // (u, v) -> u8 changed
+    remove_edge = 8,        // (u, v) -> u8 changed
+    commit = 9,             // () -> u64 version
+    stats = 10,             // () -> u32 n, n * (u8 opcode, u64 count,
+                            //        u64 p50, u64 p90, u64 p99, u64 max)
+};
+constexpr size_t opcode_num = 11;
+
+enum class Status : uint8_t { ok = 0, bad_request = 1, no_result = 2 };
+
+// Lock free latency histogram in nanoseconds: 8 linear buckets per power
+// of two, so a reported percentile is within 12.5% of the true value.
+class LatencyHistogram {
+   private:
+    static constexpr size_t bucket_num = 16 + 60 * 8;
+    std::array<std::atomic<uint64_t>, bucket_num> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> max_{0};
+
+    static size_t bucket(uint64_t ns);
+    static uint64_t upper_bound(size_t bucket);
+
+   public:
+    void record(uint64_t ns);
+    uint64_t count() const { return count_.load(); }
+    uint64_t max() const { return max_.load(); }
+    // smallest bucket bound at or above the fraction q of the samples
+    uint64_t percentile(double q) const;
+};
+
+// Resident query engine behind the daemon. Every request runs on an
+// immutable snapshot of a VersionedGraph, so requests execute concurrently
+// with each other and with updates, which become visible on commit.
+// Searches and analyses (components, levels, flow, certificate) run on a
+// DirectedGraph materialised once per version, which keeps their CSR and
+// reverse CSR across requests. Derived results are built without holding
+// any lock and published first come first kept.
+class GraphService {
+   private:
+    struct Materialised;
+
+    VersionedGraph graph_;
+    ExecutionPolicy policy_;
+    // VersionedGraph has a single writer
+    std::mutex writer_mutex_{};
+    std::mutex materialised_mutex_{};
+    std::shared_ptr<Materialised> materialised_{};
+    std::array<LatencyHistogram, opcode_num> latency_{};
+
+    std::shared_ptr<Materialised> materialise(
+        const VersionedGraph::Snapshot& snapshot);
+    Status execute(Opcode opcode, const uint64_t* arguments,
+                   size_t argument_num, std::string& payload);
+
+   public:
+    explicit GraphService(
+        const DirectedGraph& graph,
+        const ExecutionPolicy& policy = ExecutionPolicy::seq());
+    ~GraphService();
+
+    // thread safe: decodes one request after its size field and returns
+    // the encoded reply, size field included
+    std::string handle(std::string_view request);
+
+    const LatencyHistogram& latency(Opcode opcode) const {
+        return latency_[size_t(opcode)];
+    }
+};
+
+// Runs requests on threads of its own, never on ThreadPool::instance():
+// a request waiting there for its parallel work could be handed another
+// request by try_run_one. Replies of one submitter may come back in any
+// order.
+class RequestExecutor {
+   public:
+    using Reply = std::function<void(std::string)>;
+
+   private:
+    GraphService& service_;
+    std::mutex mutex_{};
+    std::condition_variable ready_{};
+    std::deque<std::pair<std::string, Reply>> queue_{};
+    std::vector<std::thread> threads_{};
+    bool stop_{false};
+
+    void run();
+
+   public:
+    RequestExecutor(GraphService& service, size_t threads);
+    // answers every request already submitted before returning
+    ~RequestExecutor();
+    RequestExecutor(const RequestExecutor&) = delete;
+    RequestExecutor& operator=(const RequestExecutor&) = delete;
+
+    // reply receives the encoded reply on a request thread
+    void submit(std::string request, Reply reply);
+};
+
+}  // namespace graph_sdk
+#endif
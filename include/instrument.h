@@ -0,0 +1,145 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_INSTRUMENT_H
+#define GRAPH_SDK_INSTRUMENT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace graph_sdk {
+
+// Statistics of one instrumented call. Counters cover every thread working
+// for the call; hardware events cover the calling thread only and are
+// valid when hardware_counters is true.
+struct AlgorithmStats {
+    std::string algorithm{};
+    uint64_t vertices_visited{};
+    uint64_t edges_visited{};
+    uint64_t cells_scanned{};
+    uint64_t allocations{};
+    uint64_t allocated_bytes{};
+    uint64_t peak_scratch_bytes{};
+    double seconds{};
+    std::vector<std::pair<std::string, double>> phases{};
+    bool hardware_counters{false};
+    uint64_t cycles{};
+    uint64_t cache_misses{};
+    uint64_t branch_misses{};
+
+    std::string to_json() const;
+};
+
+// Opt-in with -DGRAPH_SDK_INSTRUMENT; otherwise the macros below expand to
+// nothing and no call is recorded.
+class Instrumentation {
+   public:
+    static constexpr size_t history_limit = 4096;
+
+    static bool enabled();
+    // Linux perf_event_open cycles, cache and branch misses
+    static void enable_hardware_counters(bool on);
+    // last call completed on this thread
+    static AlgorithmStats last();
+    // the last history_limit calls, oldest first
+    static std::vector<AlgorithmStats> history();
+    // history() and clear() in one step
+    static std::vector<AlgorithmStats> drain();
+    static void clear();
+    static void dump_json(std::ostream& os);
+
+    static void count_vertices(uint64_t n);
+    static void count_edges(uint64_t n);
+    static void count_cells(uint64_t n);
+};
+
+// Counters of one instrumented call. Threads add to the context they run
+// under; run_workers runs pool tasks under the context of the submitting
+// thread. Live bytes may drop below zero when the call frees older blocks.
+struct CallContext {
+    static constexpr int counter_num = 5;
+    std::atomic<uint64_t> counters[counter_num]{};
+    std::atomic<int64_t> live_bytes{0};
+    std::atomic<int64_t> peak_bytes{0};
+
+    // context of this thread, nullptr outside any record
+    static CallContext* current();
+};
+
+// Runs the enclosing scope of this thread under `context`.
+class ScopedContext {
+   private:
+    CallContext* previous_{};
+
+   public:
+    explicit ScopedContext(CallContext* context);
+    ~ScopedContext();
+    ScopedContext(const ScopedContext&) = delete;
+    ScopedContext& operator=(const ScopedContext&) = delete;
+};
+
+class ScopedRecord {
+   private:
+    AlgorithmStats stats_{};
+    ScopedRecord* previous_{};
+    CallContext context_{};
+    // receives the counters and the peak of this call when it ends
+    CallContext* parent_{};
+    int perf_fd_[3]{-1, -1, -1};
+    std::chrono::steady_clock::time_point begin_{};
+
+   public:
+    explicit ScopedRecord(const char* algorithm);
+    ~ScopedRecord();
+    ScopedRecord(const ScopedRecord&) = delete;
+    ScopedRecord& operator=(const ScopedRecord&) = delete;
+
+    void add_phase(const char* name, double seconds);
+    static ScopedRecord* active();
+};
+
+class ScopedPhase {
+   private:
+    const char* name_{};
+    std::chrono::steady_clock::time_point begin_{};
+
+   public:
+    explicit ScopedPhase(const char* name)
+        : name_(name), begin_(std::chrono::steady_clock::now()) {}
+    ~ScopedPhase() {
+        if (auto* record = ScopedRecord::active()) {
+            std::chrono::duration<double> d =
+                std::chrono::steady_clock::now() - begin_;
+            record->add_phase(name_, d.count());
+        }
+    }
+};
+
+}  // namespace graph_sdk
+
+#ifdef GRAPH_SDK_INSTRUMENT
+#define GRAPH_SDK_CONCAT_(a, b) a##b
+#define GRAPH_SDK_CONCAT(a, b) GRAPH_SDK_CONCAT_(a, b)
+#define GRAPH_SDK_RECORD(name)                                      \
+    ::graph_sdk::ScopedRecord GRAPH_SDK_CONCAT(graph_sdk_record_, \
+                                               __LINE__)(name)
+#define GRAPH_SDK_PHASE(name) \
+    ::graph_sdk::ScopedPhase GRAPH_SDK_CONCAT(graph_sdk_phase_, __LINE__)(name)
+#define GRAPH_SDK_COUNT_VERTICES(n) \
+    ::graph_sdk::Instrumentation::count_vertices(n)
+#define GRAPH_SDK_COUNT_EDGES(n) ::graph_sdk::Instrumentation::count_edges(n)
+#define GRAPH_SDK_COUNT_CELLS(n) ::graph_sdk::Instrumentation::count_cells(n)
+#else
+#define GRAPH_SDK_RECORD(name) ((void)0)
+#define GRAPH_SDK_PHASE(name) ((void)0)
+#define GRAPH_SDK_COUNT_VERTICES(n) ((void)0)
+#define GRAPH_SDK_COUNT_EDGES(n) ((void)0)
+#define GRAPH_SDK_COUNT_CELLS(n) ((void)0)
+#endif
+
+#endif
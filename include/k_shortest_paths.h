@@ -0,0 +1,92 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_K_SHORTEST_PATHS_H
+#define GRAPH_SDK_K_SHORTEST_PATHS_H
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "../include/csr.h"
+#include "../include/graph.h"
+#include "../include/parallel.h"
+#include "../include/workspace.h"
+
+namespace graph_sdk {
+
+struct WeightedPath {
+    int64_t cost{};
+    std::vector<size_t> nodes{};
+};
+
+// Yen's k shortest simple paths from source to sink, weights must not be
+// negative. Paths are produced lazily by next(), in order of increasing
+// cost; the result does not depend on the thread count.
+//
+// One Dijkstra from the sink over the reverse graph is shared by every
+// spur search: its tree gives the spur path directly when that path avoids
+// the removed nodes and edges, and its distances are an exact A* bound
+// otherwise. Spur searches of one path run in parallel, each only from the
+// nodes at or after the point where that path left its parent (Lawler).
+class KShortestPaths {
+   private:
+    struct Candidate {
+        int64_t cost{};
+        std::vector<size_t> nodes{};
+        // spurs of this path start at nodes[deviation] or later
+        size_t deviation{};
+
+        bool operator<(const Candidate& other) const {
+            return std::tie(cost, nodes) < std::tie(other.cost, other.nodes);
+        }
+    };
+    struct Scratch {
+        StampedArray<size_t> parent{};
+        StampedArray<int64_t> cost{};
+        StampedArray<unsigned char> state{};
+        std::vector<std::pair<int64_t, size_t>> heap{};
+    };
+
+    // wide_graph_ instead when the graph exceeds uint32_t ids
+    std::shared_ptr<const CsrGraph<>> graph_{};
+    std::shared_ptr<const CsrGraph64> wide_graph_{};
+    // weights_[e] belongs to the targets()[e] of the graph
+    std::vector<int64_t> weights_{};
+    // distance to sink and next node towards it, in the whole graph
+    std::vector<int64_t> distance_{};
+    std::vector<size_t> successor_{};
+    size_t source_{};
+    size_t sink_{};
+    ExecutionPolicy policy_;
+    std::vector<Candidate> accepted_{};
+    std::set<Candidate> candidates_{};
+    std::vector<Scratch> scratch_{};
+    bool started_{false};
+
+    template <class Graph>
+    void build(const Graph& graph, const Graph& reverse,
+               const WeightedEdges& weighted);
+    template <class Graph>
+    bool spur(const Graph& graph, const Candidate& path, size_t i,
+              Scratch& scratch, Candidate& result) const;
+    bool spur(const Candidate& path, size_t i, Scratch& scratch,
+              Candidate& result) const;
+
+   public:
+    KShortestPaths(const DiWeightedGraph& graph, size_t source, size_t sink,
+                   const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+    // false once every simple path has been returned
+    std::pair<bool, WeightedPath> next();
+};
+
+// the first k paths of KShortestPaths, fewer when there are not k
+std::vector<WeightedPath> k_shortest_paths(
+    const DiWeightedGraph& graph, size_t source, size_t sink, size_t k,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+}  // namespace graph_sdk
+#endif
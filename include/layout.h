@@ -0,0 +1,71 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_LAYOUT_H
+#define GRAPH_SDK_LAYOUT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../include/graph.h"
+#include "../include/parallel.h"
+
+namespace graph_sdk {
+
+struct Layout {
+    std::vector<double> x{};
+    std::vector<double> y{};
+
+    size_t node_num() const { return x.size(); }
+};
+
+// Barnes-Hut quadtree over weighted points. Cells are stored flat, children
+// after their parent; a cell deeper than the depth limit keeps every
+// further point as an aggregate, so coincident points do not recurse.
+class QuadTree {
+   private:
+    struct Cell {
+        double cx{}, cy{}, half{};
+        double mass{}, mx{}, my{};
+        int32_t child[4]{-1, -1, -1, -1};
+        // the single point of a leaf, -1 for an empty or inner cell
+        int32_t point{-1};
+        bool bucket{false};
+    };
+    static constexpr size_t max_depth = 40;
+    std::vector<Cell> cells_{};
+
+    size_t make_child(size_t c, size_t quadrant);
+
+   public:
+    void build(const std::vector<double>& x, const std::vector<double>& y,
+               const std::vector<double>& mass);
+
+    // Repulsion on point i, strength * m_i * m_j / d from every point j;
+    // a cell seen under an angle (width / distance) below theta acts
+    // through its centre of mass.
+    void repulsion(size_t i, const std::vector<double>& x,
+                   const std::vector<double>& y,
+                   const std::vector<double>& mass, double theta,
+                   double strength, double& fx, double& fy) const;
+};
+
+// Multilevel spring-electrical layout (Hu) of the underlying undirected
+// graph. The first coarsening level collapses strongly connected
+// components as meta_graph() does, further levels contract heavy-edge
+// matchings. The coarsest level starts from random positions, every finer
+// level from its parents' positions. Repulsion uses the quadtree, forces
+// are evaluated in parallel; the same seed gives the same layout for every
+// policy.
+Layout force_directed_layout(
+    const DirectedGraph& graph, size_t iterations = 300, unsigned seed = 0,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+// Headless output: a `node x y` line per node, then a `source target` line
+// per edge, each section after a `#` header line. False when the file
+// could not be written.
+bool write_layout(const std::string& path, const DirectedGraph& graph,
+                  const Layout& layout);
+
+}  // namespace graph_sdk
+#endif
@@ -0,0 +1,103 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_MATCHING_H
+#define GRAPH_SDK_MATCHING_H
+
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace graph_sdk {
+
+enum class BipartiteSide : char { excluded, left, right };
+
+// Hopcroft-Karp, O(E sqrt(V)). Only edges from a left node to a right node
+// are used. mate[v] is the partner of v, max(node_type) when unmatched. A
+// greedy pass matches most nodes before the first phase; every phase is a
+// bfs layering from the free left nodes and an iterative dfs that augments
+// along vertex disjoint shortest paths.
+template <class Graph>
+size_t hopcroft_karp(const Graph& graph,
+                     const std::vector<BipartiteSide>& side,
+                     std::vector<typename Graph::node_type>& mate) {
+    using NodeId = typename Graph::node_type;
+    using Iterator = decltype(graph.neighbours(0).begin());
+    constexpr auto none = std::numeric_limits<NodeId>::max();
+    const auto V = graph.node_num();
+    mate.assign(V, none);
+    std::vector<NodeId> left_nodes{};
+    for (size_t i = 0; i < V; ++i) {
+        if (side[i] == BipartiteSide::left) left_nodes.push_back(NodeId(i));
+    }
+
+    size_t matched = 0;
+    for (auto u : left_nodes) {
+        for (auto v : graph.neighbours(u)) {
+            if (side[v] != BipartiteSide::right || mate[v] != none) continue;
+            mate[u] = NodeId(v);
+            mate[v] = u;
+            matched += 1;
+            break;
+        }
+    }
+
+    std::vector<NodeId> distance(V, none), queue{};
+    std::vector<std::pair<NodeId, Iterator>> frames{};
+    while (true) {
+        queue.clear();
+        for (auto u : left_nodes) {
+            distance[u] = mate[u] == none ? 0 : none;
+            if (mate[u] == none) queue.push_back(u);
+        }
+        // layer of the left nodes that end the shortest augmenting paths
+        NodeId limit = none;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            auto u = queue[head];
+            if (distance[u] >= limit) break;
+            for (auto v : graph.neighbours(u)) {
+                if (side[v] != BipartiteSide::right) continue;
+                auto w = mate[v];
+                if (w == none) {
+                    limit = distance[u];
+                } else if (distance[w] == none) {
+                    distance[w] = distance[u] + 1;
+                    queue.push_back(w);
+                }
+            }
+        }
+        if (limit == none) break;
+
+        for (auto u : left_nodes) {
+            if (mate[u] != none) continue;
+            frames.emplace_back(u, graph.neighbours(u).begin());
+            while (!frames.empty()) {
+                auto& [x, it] = frames.back();
+                if (it == graph.neighbours(x).end()) {
+                    distance[x] = none;
+                    frames.pop_back();
+                    continue;
+                }
+                size_t v = *it++;
+                if (side[v] != BipartiteSide::right) continue;
+                auto w = mate[v];
+                if (w == none && distance[x] == limit) {
+                    for (auto& [y, next] : frames) {
+                        auto z = *std::prev(next);
+                        mate[y] = NodeId(z);
+                        mate[z] = y;
+                    }
+                    matched += 1;
+                    frames.clear();
+                } else if (w != none && distance[x] < limit &&
+                           distance[w] == distance[x] + 1) {
+                    frames.emplace_back(w, graph.neighbours(w).begin());
+                }
+            }
+        }
+    }
+    return matched;
+}
+
+}  // namespace graph_sdk
+#endif
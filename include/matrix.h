@@ -4,12 +4,15 @@
 #define GRAPH_SDK_MATRIX_H
 
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include <numeric>
 #include <set>
 #include <stack>
 #include <tuple>
 #include <vector>
 
+#include "../include/parallel.h"
 #include "../include/utils.h"
 namespace graph_sdk {
 
@@ -92,6 +95,50 @@ class Matrix {
     size_t rows_{};
     size_t cols_{};
 
+    // sorts n lines of length len, at(line, k) reads element k of a line
+    template <class At>
+    static std::vector<size_t> line_order(size_t n, size_t len,
+                                          const ExecutionPolicy& policy,
+                                          At at) {
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+        if (n < 2 || len == 0) return order;
+
+        size_t prefix = std::min<size_t>(len, 16);
+        std::vector<T> values{};
+        values.reserve(n * prefix);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t k = 0; k < prefix; ++k) values.push_back(at(i, k));
+        }
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+        size_t bits = 1;
+        while (bits < 64 && (uint64_t{1} << bits) < values.size()) ++bits;
+        prefix = std::min(prefix, std::max<size_t>(1, 64 / bits));
+
+        std::vector<uint64_t> key(n, 0);
+        parallel_for(policy, 0, n, 1024, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                for (size_t k = 0; k < prefix; ++k) {
+                    auto rank = std::lower_bound(values.begin(), values.end(),
+                                                 at(i, k)) -
+                                values.begin();
+                    key[i] = (key[i] << bits) | uint64_t(rank);
+                }
+            }
+        });
+        parallel_stable_sort(
+            policy, order.begin(), order.end(), [&](size_t a, size_t b) {
+                if (key[a] != key[b]) return key[a] < key[b];
+                for (size_t k = prefix; k < len; ++k) {
+                    if (at(a, k) < at(b, k)) return true;
+                    if (at(b, k) < at(a, k)) return false;
+                }
+                return false;
+            });
+        return order;
+    }
+
    public:
     Matrix() = default;
 
@@ -219,22 +266,50 @@ class Matrix {
         return result;
     }
 
-    std::tuple<std::vector<size_t>, Matrix> row_sort_with_indice() const {
-        Matrix m(mat_);
-        std::sort(m.mat_.begin(), m.mat_.end(), RowCom());
-        RowCom rc;
-        std::vector<size_t> idx(rows_);
-        std::iota(idx.begin(), idx.end(), 0);
-        std::sort(idx.begin(), idx.end(),
-                  [&](size_t r1, size_t r2) { return rc(mat_[r1], mat_[r2]); });
-        return std::make_tuple(idx, m);
+    // Permutation sorting the rows (columns) lexicographically, equal rows
+    // keep their order. Every row gets a 64-bit key packing the dense ranks
+    // of its leading elements, which preserves the order, so most
+    // comparisons are one integer compare; only equal keys fall back to
+    // the remaining elements.
+    std::vector<size_t> row_order(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const {
+        return line_order(rows_, cols_, policy,
+                          [&](size_t r, size_t c) { return mat_[r][c]; });
+    }
+
+    std::vector<size_t> col_order(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const {
+        return line_order(cols_, rows_, policy,
+                          [&](size_t c, size_t r) { return mat_[r][c]; });
+    }
+
+    Matrix permute_rows(const std::vector<size_t>& order) const {
+        assert(order.size() == rows_);
+        Matrix m(rows_, cols_);
+        for (size_t i = 0; i < rows_; ++i) m.mat_[i] = mat_[order[i]];
+        return m;
+    }
+
+    Matrix permute_cols(const std::vector<size_t>& order) const {
+        assert(order.size() == cols_);
+        Matrix m(rows_, cols_);
+        for (size_t i = 0; i < rows_; ++i) {
+            for (size_t j = 0; j < cols_; ++j)
+                m.mat_[i][j] = mat_[i][order[j]];
+        }
+        return m;
+    }
+
+    std::tuple<std::vector<size_t>, Matrix> row_sort_with_indice(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const {
+        auto idx = row_order(policy);
+        return std::make_tuple(idx, permute_rows(idx));
     }
 
-    std::tuple<std::vector<size_t>, Matrix> col_sort_with_indice() const {
-        Matrix m(mat_);
-        m = m.transpose();
-        auto [idx, mc] = m.row_sort_with_indice();
-        return std::make_tuple(idx, mc.transpose());
+    std::tuple<std::vector<size_t>, Matrix> col_sort_with_indice(
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const {
+        auto idx = col_order(policy);
+        return std::make_tuple(idx, permute_cols(idx));
     }
 
     friend bool operator==(const Matrix& m1, const Matrix& m2) {
@@ -0,0 +1,110 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_MS_BFS_H
+#define GRAPH_SDK_MS_BFS_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "../include/bit_matrix.h"
+#include "../include/parallel.h"
+
+namespace graph_sdk {
+
+// Multi-source BFS (Then et al., VLDB 2015): every vertex carries one bit per
+// source of the batch, so one scan of an adjacency row advances all sources
+// at once. Words = 1 gives 64 sources per batch, Words = 4 gives 256 bits
+// handled with fixed-length loops the compiler turns into AVX2 code.
+template <size_t Words, class Graph, class Reach>
+void ms_bfs_batch(const Graph& graph, const size_t* sources, size_t count,
+                  Reach&& reach) {
+    using Mask = std::array<uint64_t, Words>;
+    auto none = [](const Mask& m) {
+        uint64_t any = 0;
+        for (size_t w = 0; w < Words; ++w) any |= m[w];
+        return any == 0;
+    };
+    const auto V = graph.node_num();
+    std::vector<Mask> seen(V, Mask{}), visit(V, Mask{}), next(V, Mask{});
+    std::vector<size_t> active{}, next_active{};
+
+    for (size_t i = 0; i < count; ++i) {
+        auto s = sources[i];
+        if (none(visit[s])) active.push_back(s);
+        seen[s][i / 64] |= uint64_t{1} << (i % 64);
+        visit[s][i / 64] |= uint64_t{1} << (i % 64);
+        reach(i, s, size_t{0});
+    }
+
+    for (size_t level = 1; !active.empty(); ++level) {
+        next_active.clear();
+        for (auto v : active) {
+            for (auto n : graph.neighbours(v)) {
+                bool empty = none(next[n]);
+                for (size_t w = 0; w < Words; ++w) next[n][w] |= visit[v][w];
+                if (empty) next_active.push_back(n);
+            }
+        }
+        for (auto v : active) visit[v] = Mask{};
+
+        size_t kept = 0;
+        for (auto n : next_active) {
+            Mask fresh{};
+            for (size_t w = 0; w < Words; ++w) {
+                fresh[w] = next[n][w] & ~seen[n][w];
+                seen[n][w] |= fresh[w];
+            }
+            next[n] = Mask{};
+            if (none(fresh)) continue;
+            visit[n] = fresh;
+            for (size_t w = 0; w < Words; ++w) {
+                for (auto bits = fresh[w]; bits != 0; bits &= bits - 1)
+                    reach(w * 64 + __builtin_ctzll(bits), n, level);
+            }
+            next_active[kept++] = n;
+        }
+        next_active.resize(kept);
+        std::swap(active, next_active);
+    }
+}
+
+// Hop distances from every source: result[i * V + v] is the distance from
+// sources[i] to v, max(node_type) when unreachable. Batches of 64 * Words
+// sources run in parallel.
+template <size_t Words = 1, class Graph>
+std::vector<typename Graph::node_type> multi_source_distances(
+    const Graph& graph, const std::vector<size_t>& sources,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq()) {
+    using NodeId = typename Graph::node_type;
+    const auto V = graph.node_num();
+    const size_t batch = 64 * Words;
+    std::vector<NodeId> distance(sources.size() * V,
+                                 std::numeric_limits<NodeId>::max());
+    parallel_for(policy, 0, sources.size(), batch, [&](size_t b, size_t e) {
+        ms_bfs_batch<Words>(graph, sources.data() + b, e - b,
+                            [&](size_t lane, size_t v, size_t level) {
+                                distance[(b + lane) * V + v] = NodeId(level);
+                            });
+    });
+    return distance;
+}
+
+// Row i holds the nodes reachable from sources[i], itself included.
+template <size_t Words = 1, class Graph>
+BitMatrix multi_source_reachability(
+    const Graph& graph, const std::vector<size_t>& sources,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq()) {
+    const size_t batch = 64 * Words;
+    BitMatrix reachable(sources.size(), graph.node_num());
+    parallel_for(policy, 0, sources.size(), batch, [&](size_t b, size_t e) {
+        ms_bfs_batch<Words>(
+            graph, sources.data() + b, e - b,
+            [&](size_t lane, size_t v, size_t) { reachable.set(b + lane, v); });
+    });
+    return reachable;
+}
+
+}  // namespace graph_sdk
+#endif
@@ -0,0 +1,74 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_PAGERANK_H
+#define GRAPH_SDK_PAGERANK_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../include/csr.h"
+#include "../include/graph.h"
+#include "../include/parallel.h"
+
+namespace graph_sdk {
+
+// PageRank over a snapshot of a graph. The in-edges, inverse out-degrees
+// and sinks are computed once, so repeated runs with other parameters or
+// seeds only pay for the iterations.
+class PageRank {
+   private:
+    template <typename NodeId, typename EdgeId>
+    struct Topology {
+        CsrGraph<NodeId, EdgeId> out_edges{};
+        CsrGraph<NodeId, EdgeId> in_edges{};
+    };
+    // only wide_ is filled when the graph exceeds uint32_t ids
+    Topology<uint32_t, uint32_t> narrow_{};
+    Topology<uint64_t, uint64_t> wide_{};
+    bool is_wide_{false};
+    // 1 / out-degree, 0 for sinks
+    std::vector<double> inverse_degree_{};
+    std::vector<size_t> sinks_{};
+
+    template <typename NodeId, typename EdgeId>
+    void build(Topology<NodeId, EdgeId>& topology,
+               const CsrGraph<NodeId, EdgeId>& out_edges);
+    template <typename NodeId, typename EdgeId>
+    std::pair<bool, std::vector<double>> rank(
+        const Topology<NodeId, EdgeId>& topology, double damping,
+        double tolerance, size_t max_iterations,
+        const ExecutionPolicy& policy) const;
+    template <typename NodeId, typename EdgeId>
+    std::vector<std::vector<std::pair<size_t, double>>> personalized(
+        const Topology<NodeId, EdgeId>& topology,
+        const std::vector<size_t>& seeds, double damping, double epsilon,
+        const ExecutionPolicy& policy) const;
+
+   public:
+    explicit PageRank(const DirectedGraph& graph);
+
+    size_t node_num() const { return inverse_degree_.size(); }
+    const std::vector<size_t>& sinks() const { return sinks_; }
+
+    // Power iteration pulling rank over in-edges; the rank of sinks is
+    // spread uniformly. Stops once the L1 change of an iteration is below
+    // tolerance, the flag is false when max_iterations ran out first.
+    std::pair<bool, std::vector<double>> rank(
+        double damping = 0.85, double tolerance = 1e-9,
+        size_t max_iterations = 100,
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
+
+    // Approximate personalized PageRank of every seed by forward push
+    // (Andersen, Chung and Lang): a node pushes while its residual is at
+    // least epsilon times its out-degree, and sinks return their mass to
+    // the seed. Entries are the nodes of non-zero estimate, ascending;
+    // seeds are processed in parallel.
+    std::vector<std::vector<std::pair<size_t, double>>> personalized(
+        const std::vector<size_t>& seeds, double damping = 0.85,
+        double epsilon = 1e-7,
+        const ExecutionPolicy& policy = ExecutionPolicy::seq()) const;
+};
+
+}  // namespace graph_sdk
+#endif
@@ -4,6 +4,7 @@
 #define GRAPH_SDK_PAINT_H
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <numeric>
 #include <set>
@@ -43,13 +44,20 @@ struct Vec2Com {
     }
 };
 
-Matrix<int> remove_sources(const std::vector<size_t>& sources,
-                           const Matrix<int>& di_matrix);
+Matrix<int> remove_sources(
+    const std::vector<size_t>& sources, const Matrix<int>& di_matrix,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
 
 std::vector<int> extract_node_description(const size_t node,
                                           const Matrix<int>& edge_color_matrix);
 
-std::vector<size_t> extract_sources(const Matrix<int>& di_matrix);
+std::vector<size_t> extract_sources(
+    const Matrix<int>& di_matrix,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+std::vector<size_t> extract_sinks(
+    const Matrix<int>& di_matrix,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
 
 std::tuple<std::set<std::pair<size_t, size_t>>,
            std::unordered_map<size_t, std::vector<int>>>
@@ -68,11 +76,24 @@ void update_edge_color(const std::vector<size_t>& sources,
                        std::unordered_set<int>& label_set);
 
 void paint_once(Matrix<int>& edge_color_matrix, int& max_edge_color,
-                Matrix<int>& curr_matrix);
-
-Matrix<int> paint_graph(const Matrix<int>& di_matrix);
-
-Matrix<int> generate_description(const Matrix<int>& edge_color_matrix);
+                Matrix<int>& curr_matrix,
+                const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+Matrix<int> paint_graph(const Matrix<int>& di_matrix,
+                        const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+Matrix<int> generate_description(
+    const Matrix<int>& edge_color_matrix,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
+
+// Colour refinement like paint_graph, over the CSR out- and in-edges
+// instead of the dense edge colour matrix: colours are 64-bit hashes of a
+// node's colour and the sorted colours of its neighbours, refined until the
+// partition is stable. Isomorphic graphs get equal certificates; the
+// converse holds for most graphs but not for every regular one.
+uint64_t refinement_certificate(
+    const DirectedGraph& graph,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq());
 
 }  // namespace graph_sdk
 #endif
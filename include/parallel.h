@@ -0,0 +1,162 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_PARALLEL_H
+#define GRAPH_SDK_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../include/instrument.h"
+
+namespace graph_sdk {
+
+// seq(): run on the calling thread, par(): all hardware threads,
+// par(n): at most n threads. Algorithms give identical results for every
+// policy; work is split into chunks that do not depend on the thread count.
+class ExecutionPolicy {
+   private:
+    size_t threads_{1};
+    explicit ExecutionPolicy(size_t threads) : threads_(threads) {}
+
+   public:
+    static ExecutionPolicy seq() { return ExecutionPolicy(1); }
+    static ExecutionPolicy par() {
+        return ExecutionPolicy(
+            std::max<size_t>(1, std::thread::hardware_concurrency()));
+    }
+    static ExecutionPolicy par(size_t threads) {
+        return ExecutionPolicy(std::max<size_t>(1, threads));
+    }
+
+    size_t threads() const { return threads_; }
+    bool is_parallel() const { return threads_ > 1; }
+};
+
+// Work-stealing pool: every worker owns a deque, pops its own tail and
+// steals from the head of the others. One process-wide pool is shared by
+// all algorithms so threads are never spawned per call.
+class ThreadPool {
+   public:
+    using Task = std::function<void()>;
+
+   private:
+    struct Queue {
+        std::mutex mutex{};
+        std::deque<Task> tasks{};
+    };
+    std::vector<std::unique_ptr<Queue>> queues_{};
+    std::vector<std::thread> threads_{};
+    std::mutex sleep_mutex_{};
+    std::condition_variable wake_{};
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> next_queue_{0};
+    std::atomic<bool> stop_{false};
+
+    bool pop_or_steal(size_t self, Task& task);
+    void worker_loop(size_t self);
+
+   public:
+    explicit ThreadPool(size_t workers);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return threads_.size(); }
+    void submit(Task task);
+    // run one queued task on the calling thread, false if none was found
+    bool try_run_one();
+
+    static ThreadPool& instance();
+};
+
+// Runs fn(worker) on min(policy.threads(), workers) threads, the calling
+// thread being worker 0, and returns when all of them have finished.
+// Workers count for the instrumented call of the calling thread.
+template <class Function>
+void run_workers(const ExecutionPolicy& policy, size_t workers,
+                 Function&& fn) {
+    workers = std::min(workers, policy.threads());
+    if (workers <= 1) {
+        if (workers == 1) fn(size_t{0});
+        return;
+    }
+    auto& pool = ThreadPool::instance();
+    auto* context = CallContext::current();
+    std::atomic<size_t> remaining{workers - 1};
+    for (size_t w = 1; w < workers; ++w) {
+        pool.submit([&, w]() {
+            {
+                ScopedContext scope(context);
+                fn(w);
+            }
+            remaining.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    fn(size_t{0});
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!pool.try_run_one()) std::this_thread::yield();
+    }
+}
+
+// Calls fn(chunk_begin, chunk_end) for consecutive chunks of `grain`
+// indices in [begin, end). Chunk boundaries only depend on `grain`.
+template <class Function>
+void parallel_for(const ExecutionPolicy& policy, size_t begin, size_t end,
+                  size_t grain, Function&& fn) {
+    if (begin >= end) return;
+    grain = std::max<size_t>(grain, 1);
+    const size_t chunks = (end - begin + grain - 1) / grain;
+    if (!policy.is_parallel() || chunks == 1) {
+        for (size_t b = begin; b < end; b += grain)
+            fn(b, std::min(b + grain, end));
+        return;
+    }
+    std::atomic<size_t> next{0};
+    run_workers(policy, chunks, [&](size_t) {
+        for (auto c = next.fetch_add(1); c < chunks; c = next.fetch_add(1)) {
+            auto b = begin + c * grain;
+            fn(b, std::min(b + grain, end));
+        }
+    });
+}
+
+// Stable sort: chunks of `grain` elements are sorted in parallel and then
+// merged pairwise, so the result does not depend on the thread count.
+template <class Iterator, class Compare>
+void parallel_stable_sort(const ExecutionPolicy& policy, Iterator first,
+                          Iterator last, Compare comp) {
+    using Value = typename std::iterator_traits<Iterator>::value_type;
+    const size_t n = last - first;
+    const size_t grain = 4096;
+    if (!policy.is_parallel() || n <= grain) {
+        std::stable_sort(first, last, comp);
+        return;
+    }
+    parallel_for(policy, 0, n, grain, [&](size_t b, size_t e) {
+        std::stable_sort(first + b, first + e, comp);
+    });
+    std::vector<Value> buffer(n);
+    for (size_t width = grain; width < n; width *= 2) {
+        parallel_for(policy, 0, n, 2 * width, [&](size_t b, size_t e) {
+            auto mid = std::min(b + width, e);
+            std::merge(std::make_move_iterator(first + b),
+                       std::make_move_iterator(first + mid),
+                       std::make_move_iterator(first + mid),
+                       std::make_move_iterator(first + e),
+                       buffer.begin() + b, comp);
+            std::move(buffer.begin() + b, buffer.begin() + e, first + b);
+        });
+    }
+}
+
+}  // namespace graph_sdk
+#endif
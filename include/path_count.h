@@ -0,0 +1,271 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_PATH_COUNT_H
+#define GRAPH_SDK_PATH_COUNT_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/csr.h"
+#include "../include/graph.h"
+#include "../include/parallel.h"
+#include "../include/topological_levels.h"
+
+namespace graph_sdk {
+
+// Arbitrary precision unsigned integer, as much as path counting needs.
+class BigUint {
+   private:
+    // base 2^32, least significant first, no leading zero limbs
+    std::vector<uint32_t> limbs_{};
+
+   public:
+    BigUint() = default;
+    BigUint(uint64_t value);
+
+    BigUint& operator+=(const BigUint& other);
+    BigUint operator*(const BigUint& other) const;
+    bool operator==(const BigUint& other) const {
+        return limbs_ == other.limbs_;
+    }
+    bool operator!=(const BigUint& other) const { return !(*this == other); }
+    bool is_zero() const { return limbs_.empty(); }
+    // decimal
+    std::string to_string() const;
+};
+
+// Residue modulo a prime below 2^63, 2^61 - 1 by default.
+template <uint64_t Modulus = (uint64_t{1} << 61) - 1>
+struct ModCount {
+    static_assert(Modulus > 1 && Modulus < (uint64_t{1} << 63),
+                  "ModCount needs 1 < Modulus < 2^63");
+    uint64_t value{};
+
+    ModCount() = default;
+    ModCount(uint64_t x) : value(x % Modulus) {}
+
+    ModCount& operator+=(ModCount other) {
+        value += other.value;
+        if (value >= Modulus) value -= Modulus;
+        return *this;
+    }
+    ModCount operator*(ModCount other) const {
+        ModCount product{};
+        product.value =
+            uint64_t((unsigned __int128)value * other.value % Modulus);
+        return product;
+    }
+    bool operator==(ModCount other) const { return value == other.value; }
+    bool operator!=(ModCount other) const { return value != other.value; }
+};
+
+// Exact up to 2^128 - 1; a count beyond saturates at that value.
+using PathCount128 = unsigned __int128;
+
+inline void add_paths(PathCount128& a, PathCount128 b) {
+    if (__builtin_add_overflow(a, b, &a))
+        a = std::numeric_limits<PathCount128>::max();
+}
+
+inline PathCount128 multiply_paths(PathCount128 a, PathCount128 b) {
+    PathCount128 product{};
+    if (__builtin_mul_overflow(a, b, &product))
+        return std::numeric_limits<PathCount128>::max();
+    return product;
+}
+
+template <class Count>
+void add_paths(Count& a, const Count& b) {
+    a += b;
+}
+
+template <class Count>
+Count multiply_paths(const Count& a, const Count& b) {
+    return a * b;
+}
+
+// Counts paths of a DAG by dynamic programming over its topological
+// levels instead of enumerating them: a node sums the counts of its
+// predecessors, O(V + E) per source and no more. Several sources are swept
+// together, each node holding one lane per source, and the nodes of a
+// level are summed in parallel. Count is PathCount128, BigUint or
+// ModCount; every query is false on a cyclic graph.
+template <class Count>
+class PathCounter {
+   private:
+    // the wide pair instead when the graph exceeds uint32_t ids
+    std::shared_ptr<const CsrGraph<>> graph_{};
+    std::shared_ptr<const CsrGraph<>> reverse_{};
+    std::shared_ptr<const CsrGraph64> wide_graph_{};
+    std::shared_ptr<const CsrGraph64> wide_reverse_{};
+    std::shared_ptr<const TopologicalLevels> levels_;
+    ExecutionPolicy policy_;
+
+    // visit(graph, reverse) on whichever pair is filled
+    template <class Visit>
+    auto with_csr(Visit&& visit) const {
+        if (wide_graph_) return visit(*wide_graph_, *wide_reverse_);
+        return visit(*graph_, *reverse_);
+    }
+
+    // lanes[v * lane_num + k]: paths to v from the seeds of lane k, or
+    // from v to them when backward
+    std::vector<Count> sweep(
+        const std::vector<std::pair<size_t, size_t>>& seeds, size_t lane_num,
+        bool backward) const {
+        const auto V = node_num();
+        std::vector<Count> lanes(V * lane_num, Count{});
+        for (auto [v, k] : seeds) {
+            assert(v < V && k < lane_num);
+            add_paths(lanes[v * lane_num + k], Count(1));
+        }
+        with_csr([&](const auto& graph, const auto& reverse) {
+            const auto& pull = backward ? graph : reverse;
+            const auto level_num = levels_->level_num();
+            for (size_t step = 0; step < level_num; ++step) {
+                auto level =
+                    levels_->level(backward ? level_num - 1 - step : step);
+                parallel_for(policy_, 0, level.size(), 256,
+                             [&](size_t b, size_t e) {
+                    for (auto i = b; i < e; ++i) {
+                        auto row = lanes.data() + level[i] * lane_num;
+                        for (size_t u : pull.neighbours(level[i])) {
+                            auto from = lanes.data() + u * lane_num;
+                            for (size_t k = 0; k < lane_num; ++k)
+                                add_paths(row[k], from[k]);
+                        }
+                    }
+                });
+            }
+        });
+        return lanes;
+    }
+
+    // nodes without predecessors, or without successors when backward
+    std::vector<std::pair<size_t, size_t>> ends(bool backward) const {
+        return with_csr([&](const auto& graph, const auto& reverse) {
+            const auto& ending = backward ? graph : reverse;
+            std::vector<std::pair<size_t, size_t>> seeds{};
+            for (size_t v = 0; v < ending.node_num(); ++v) {
+                if (ending.degree(v) == 0) seeds.emplace_back(v, 0);
+            }
+            return seeds;
+        });
+    }
+
+    std::vector<Count> through_edges(const std::vector<Count>& from,
+                                     const std::vector<Count>& to) const {
+        return with_csr([&](const auto& graph, const auto&) {
+            std::vector<Count> counts(graph.edge_num());
+            for (size_t v = 0; v < graph.node_num(); ++v) {
+                for (auto e = graph.offsets()[v]; e < graph.offsets()[v + 1];
+                     ++e)
+                    counts[e] =
+                        multiply_paths(from[v], to[graph.targets()[e]]);
+            }
+            return counts;
+        });
+    }
+
+   public:
+    // sources swept together by count()
+    static constexpr size_t batch_lanes = 64;
+
+    explicit PathCounter(
+        const DirectedGraph& graph,
+        const ExecutionPolicy& policy = ExecutionPolicy::seq())
+        : levels_(graph.cached_topological_levels(policy)), policy_(policy) {
+        if (graph.fits_csr32()) {
+            graph_ = graph.cached_csr();
+            reverse_ = graph.cached_reverse_csr();
+        } else {
+            wide_graph_ = graph.cached_wide_csr();
+            wide_reverse_ = graph.cached_wide_reverse_csr();
+        }
+    }
+
+    bool is_dag() const { return levels_->is_dag(); }
+    size_t node_num() const {
+        return with_csr([](const auto& graph, const auto&) {
+            return graph.node_num();
+        });
+    }
+
+    // paths from source to every node
+    std::pair<bool, std::vector<Count>> from(size_t source) const {
+        if (!is_dag()) return {false, {}};
+        return {true, sweep({{source, 0}}, 1, false)};
+    }
+
+    // paths from every node to sink
+    std::pair<bool, std::vector<Count>> to(size_t sink) const {
+        if (!is_dag()) return {false, {}};
+        return {true, sweep({{sink, 0}}, 1, true)};
+    }
+
+    // one count per (source, sink) pair, every distinct source gets a lane
+    std::pair<bool, std::vector<Count>> count(
+        const std::vector<std::pair<size_t, size_t>>& pairs) const {
+        if (!is_dag()) return {false, {}};
+        std::vector<size_t> sources{};
+        for (const auto& pair : pairs) sources.push_back(pair.first);
+        std::sort(sources.begin(), sources.end());
+        sources.erase(std::unique(sources.begin(), sources.end()),
+                      sources.end());
+        std::vector<size_t> lane(pairs.size());
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            lane[i] = size_t(std::lower_bound(sources.begin(), sources.end(),
+                                              pairs[i].first) -
+                             sources.begin());
+        }
+        std::vector<Count> counts(pairs.size(), Count{});
+        for (size_t first = 0; first < sources.size(); first += batch_lanes) {
+            const auto last = std::min(first + batch_lanes, sources.size());
+            std::vector<std::pair<size_t, size_t>> seeds{};
+            for (auto k = first; k < last; ++k)
+                seeds.emplace_back(sources[k], k - first);
+            const auto lane_num = last - first;
+            const auto lanes = sweep(seeds, lane_num, false);
+            for (size_t i = 0; i < pairs.size(); ++i) {
+                if (lane[i] >= first && lane[i] < last)
+                    counts[i] = lanes[pairs[i].second * lane_num + lane[i] -
+                                      first];
+            }
+        }
+        return {true, counts};
+    }
+
+    // paths from any node without predecessors to any node without
+    // successors, an isolated node being a path of its own
+    std::pair<bool, Count> total() const {
+        if (!is_dag()) return {false, Count{}};
+        const auto from = sweep(ends(false), 1, false);
+        Count sum{};
+        for (auto [v, lane] : ends(true)) add_paths(sum, from[v]);
+        return {true, sum};
+    }
+
+    // source-sink paths through every edge, in the order of cached_csr()
+    std::pair<bool, std::vector<Count>> edge_counts(size_t source,
+                                                    size_t sink) const {
+        if (!is_dag()) return {false, {}};
+        return {true, through_edges(sweep({{source, 0}}, 1, false),
+                                    sweep({{sink, 0}}, 1, true))};
+    }
+
+    // the same over the maximal paths counted by total()
+    std::pair<bool, std::vector<Count>> edge_counts() const {
+        if (!is_dag()) return {false, {}};
+        return {true, through_edges(sweep(ends(false), 1, false),
+                                    sweep(ends(true), 1, true))};
+    }
+};
+
+}  // namespace graph_sdk
+#endif
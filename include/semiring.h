@@ -0,0 +1,47 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_SEMIRING_H
+#define GRAPH_SDK_SEMIRING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace graph_sdk {
+
+// A semiring supplies value_type, zero() (the identity of add and the
+// annihilator of multiply), add and multiply. The kernels of
+// sparse_matrix.h only touch values through these four members.
+
+// (or, and): reachability
+struct BooleanSemiring {
+    using value_type = uint8_t;
+    static value_type zero() { return 0; }
+    static value_type add(value_type a, value_type b) { return a | b; }
+    static value_type multiply(value_type a, value_type b) { return a & b; }
+};
+
+// (min, +): shortest paths, zero() is the unreachable distance
+template <typename T>
+struct MinPlusSemiring {
+    using value_type = T;
+    static value_type zero() { return std::numeric_limits<T>::max(); }
+    static value_type add(value_type a, value_type b) {
+        return std::min(a, b);
+    }
+    static value_type multiply(value_type a, value_type b) {
+        return (a == zero() || b == zero()) ? zero() : a + b;
+    }
+};
+
+// (+, *): path counting, PageRank
+template <typename T>
+struct PlusTimesSemiring {
+    using value_type = T;
+    static value_type zero() { return T{}; }
+    static value_type add(value_type a, value_type b) { return a + b; }
+    static value_type multiply(value_type a, value_type b) { return a * b; }
+};
+
+}  // namespace graph_sdk
+#endif
@@ -0,0 +1,309 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_SPARSE_MATRIX_H
+#define GRAPH_SDK_SPARSE_MATRIX_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../include/csr.h"
+#include "../include/graph.h"
+#include "../include/parallel.h"
+
+namespace graph_sdk {
+
+// Compressed sparse rows with a value per entry, columns sorted per row.
+template <typename T>
+class SparseMatrix {
+   private:
+    size_t rows_{};
+    size_t cols_{};
+    std::vector<size_t> offsets_{0};
+    std::vector<uint32_t> indices_{};
+    std::vector<T> values_{};
+
+   public:
+    using value_type = T;
+
+    SparseMatrix() = default;
+    SparseMatrix(size_t rows, size_t cols, std::vector<size_t> offsets,
+                 std::vector<uint32_t> indices, std::vector<T> values)
+        : rows_(rows),
+          cols_(cols),
+          offsets_(std::move(offsets)),
+          indices_(std::move(indices)),
+          values_(std::move(values)) {
+        assert(offsets_.size() == rows_ + 1);
+        assert(offsets_.back() == indices_.size());
+        assert(indices_.size() == values_.size());
+    }
+
+    // adjacency pattern, every edge holds `one`
+    static SparseMatrix pattern(const DirectedGraph& graph, T one = T(1)) {
+        auto csr = graph.to_csr<uint32_t, size_t>();
+        std::vector<T> values(csr.edge_num(), one);
+        return SparseMatrix(csr.node_num(), csr.node_num(), csr.offsets(),
+                            csr.targets(), std::move(values));
+    }
+
+    // edge weights as values
+    static SparseMatrix weights(const DiWeightedGraph& graph) {
+        auto csr = graph.to_csr<uint32_t, size_t>();
+        const auto& weighted = graph.extract_weighted_edges();
+        std::vector<T> values(csr.edge_num());
+        for (size_t i = 0; i < csr.node_num(); ++i) {
+            for (auto e = csr.offsets()[i]; e < csr.offsets()[i + 1]; ++e) {
+                auto it = weighted.find({i, csr.targets()[e]});
+                assert(it != weighted.end());
+                values[e] = T(it->second);
+            }
+        }
+        return SparseMatrix(csr.node_num(), csr.node_num(), csr.offsets(),
+                            csr.targets(), std::move(values));
+    }
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t nnz() const { return indices_.size(); }
+    size_t row_nnz(size_t i) const { return offsets_[i + 1] - offsets_[i]; }
+    const std::vector<size_t>& offsets() const { return offsets_; }
+    const std::vector<uint32_t>& indices() const { return indices_; }
+    const std::vector<T>& values() const { return values_; }
+
+    // transpose by counting sort, rows stay sorted
+    SparseMatrix transpose() const {
+        std::vector<size_t> offsets(cols_ + 1, 0);
+        for (auto j : indices_) offsets[j + 1] += 1;
+        for (size_t j = 0; j < cols_; ++j) offsets[j + 1] += offsets[j];
+        std::vector<uint32_t> indices(nnz());
+        std::vector<T> values(nnz());
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < rows_; ++i) {
+            for (auto e = offsets_[i]; e < offsets_[i + 1]; ++e) {
+                auto position = fill[indices_[e]]++;
+                indices[position] = uint32_t(i);
+                values[position] = values_[e];
+            }
+        }
+        return SparseMatrix(cols_, rows_, std::move(offsets),
+                            std::move(indices), std::move(values));
+    }
+
+    // entries for which keep(i, j, value) holds
+    template <class Predicate>
+    SparseMatrix select(Predicate keep) const {
+        std::vector<size_t> offsets(rows_ + 1, 0);
+        std::vector<uint32_t> indices{};
+        std::vector<T> values{};
+        for (size_t i = 0; i < rows_; ++i) {
+            for (auto e = offsets_[i]; e < offsets_[i + 1]; ++e) {
+                if (!keep(i, size_t(indices_[e]), values_[e])) continue;
+                indices.push_back(indices_[e]);
+                values.push_back(values_[e]);
+            }
+            offsets[i + 1] = indices.size();
+        }
+        return SparseMatrix(rows_, cols_, std::move(offsets),
+                            std::move(indices), std::move(values));
+    }
+
+    // every value replaced by f(i, j, value)
+    template <class Function>
+    SparseMatrix apply(Function f) const {
+        auto result = *this;
+        for (size_t i = 0; i < rows_; ++i) {
+            for (auto e = offsets_[i]; e < offsets_[i + 1]; ++e)
+                result.values_[e] = f(i, size_t(indices_[e]), values_[e]);
+        }
+        return result;
+    }
+};
+
+template <typename T>
+struct SparseVector {
+    std::vector<size_t> indices{};
+    std::vector<T> values{};
+
+    size_t nnz() const { return indices.size(); }
+};
+
+// Structural mask over a dense index space: an entry passes when its flag
+// is set, or when it is clear for a complemented mask. No flags lets
+// everything pass.
+struct Mask {
+    const std::vector<uint8_t>* flags{nullptr};
+    bool complement{false};
+
+    bool allows(size_t i) const {
+        return flags == nullptr || (((*flags)[i] != 0) != complement);
+    }
+};
+
+// Pull: y(i) = add over j of A(i, j) * x(j), for the rows the mask lets
+// through; the other rows of y are left as they are. Rows run in parallel.
+template <class Semiring>
+void mxv(const SparseMatrix<typename Semiring::value_type>& A,
+         const std::vector<typename Semiring::value_type>& x,
+         std::vector<typename Semiring::value_type>& y, const Mask& mask = {},
+         const ExecutionPolicy& policy = ExecutionPolicy::seq()) {
+    assert(x.size() == A.cols());
+    y.resize(A.rows(), Semiring::zero());
+    const auto& offsets = A.offsets();
+    const auto& indices = A.indices();
+    const auto& values = A.values();
+    parallel_for(policy, 0, A.rows(), 1024, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            if (!mask.allows(i)) continue;
+            auto acc = Semiring::zero();
+            for (auto k = offsets[i]; k < offsets[i + 1]; ++k)
+                acc = Semiring::add(acc,
+                                    Semiring::multiply(values[k],
+                                                       x[indices[k]]));
+            y[i] = acc;
+        }
+    });
+}
+
+// Push: the entries of x scatter along their rows of A, giving the sparse
+// product x * A restricted to the columns the mask lets through, indices
+// ascending. Chunks of x collect their products privately and the products
+// are reduced in chunk order, so the result does not depend on the thread
+// count.
+template <class Semiring>
+SparseVector<typename Semiring::value_type> vxm(
+    const SparseVector<typename Semiring::value_type>& x,
+    const SparseMatrix<typename Semiring::value_type>& A,
+    const Mask& mask = {},
+    const ExecutionPolicy& policy = ExecutionPolicy::seq()) {
+    using Value = typename Semiring::value_type;
+    const size_t grain = 256;
+    const auto& offsets = A.offsets();
+    const auto& indices = A.indices();
+    const auto& values = A.values();
+    std::vector<std::vector<std::pair<size_t, Value>>> buffers(
+        (x.nnz() + grain - 1) / grain);
+    parallel_for(policy, 0, x.nnz(), grain, [&](size_t b, size_t e) {
+        auto& buffer = buffers[b / grain];
+        for (size_t k = b; k < e; ++k) {
+            auto i = x.indices[k];
+            for (auto p = offsets[i]; p < offsets[i + 1]; ++p) {
+                if (!mask.allows(indices[p])) continue;
+                buffer.emplace_back(
+                    indices[p], Semiring::multiply(x.values[k], values[p]));
+            }
+        }
+    });
+    std::vector<std::pair<size_t, Value>> products{};
+    for (auto& buffer : buffers)
+        products.insert(products.end(), buffer.begin(), buffer.end());
+    parallel_stable_sort(
+        policy, products.begin(), products.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    SparseVector<Value> y{};
+    for (size_t k = 0; k < products.size();) {
+        auto j = products[k].first;
+        auto acc = products[k].second;
+        for (++k; k < products.size() && products[k].first == j; ++k)
+            acc = Semiring::add(acc, products[k].second);
+        y.indices.push_back(j);
+        y.values.push_back(acc);
+    }
+    return y;
+}
+
+// Gustavson SpGEMM, C = A * B. With a mask only the entries present in the
+// mask are formed, as masked triangle counting needs. Blocks of rows use a
+// private dense accumulator and are concatenated in order.
+template <class Semiring>
+SparseMatrix<typename Semiring::value_type> mxm(
+    const SparseMatrix<typename Semiring::value_type>& A,
+    const SparseMatrix<typename Semiring::value_type>& B,
+    const SparseMatrix<typename Semiring::value_type>* mask = nullptr,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq()) {
+    using Value = typename Semiring::value_type;
+    assert(A.cols() == B.rows());
+    assert(!mask || (mask->rows() == A.rows() && mask->cols() == B.cols()));
+    const size_t grain = 256;
+    const size_t blocks = (A.rows() + grain - 1) / grain;
+    std::vector<std::vector<uint32_t>> block_indices(blocks);
+    std::vector<std::vector<Value>> block_values(blocks);
+    std::vector<size_t> row_nnz(A.rows(), 0);
+
+    parallel_for(policy, 0, A.rows(), grain, [&](size_t b, size_t e) {
+        std::vector<Value> accumulator(B.cols(), Semiring::zero());
+        // 0 untouched, 1 allowed by the mask, 2 holds a value
+        std::vector<uint8_t> state(B.cols(), 0);
+        std::vector<uint32_t> touched{};
+        auto& out_indices = block_indices[b / grain];
+        auto& out_values = block_values[b / grain];
+        for (size_t i = b; i < e; ++i) {
+            if (mask) {
+                for (auto k = mask->offsets()[i]; k < mask->offsets()[i + 1];
+                     ++k)
+                    state[mask->indices()[k]] = 1;
+            }
+            for (auto p = A.offsets()[i]; p < A.offsets()[i + 1]; ++p) {
+                auto k = A.indices()[p];
+                for (auto q = B.offsets()[k]; q < B.offsets()[k + 1]; ++q) {
+                    auto j = B.indices()[q];
+                    if (mask && state[j] == 0) continue;
+                    auto product =
+                        Semiring::multiply(A.values()[p], B.values()[q]);
+                    if (state[j] == 2) {
+                        accumulator[j] = Semiring::add(accumulator[j], product);
+                    } else {
+                        accumulator[j] = product;
+                        state[j] = 2;
+                        touched.push_back(j);
+                    }
+                }
+            }
+            std::sort(touched.begin(), touched.end());
+            for (auto j : touched) {
+                out_indices.push_back(j);
+                out_values.push_back(accumulator[j]);
+                accumulator[j] = Semiring::zero();
+                state[j] = 0;
+            }
+            row_nnz[i] = touched.size();
+            touched.clear();
+            if (mask) {
+                for (auto k = mask->offsets()[i]; k < mask->offsets()[i + 1];
+                     ++k)
+                    state[mask->indices()[k]] = 0;
+            }
+        }
+    });
+
+    std::vector<size_t> offsets(A.rows() + 1, 0);
+    for (size_t i = 0; i < A.rows(); ++i)
+        offsets[i + 1] = offsets[i] + row_nnz[i];
+    std::vector<uint32_t> indices{};
+    std::vector<Value> values{};
+    indices.reserve(offsets.back());
+    values.reserve(offsets.back());
+    for (size_t k = 0; k < blocks; ++k) {
+        indices.insert(indices.end(), block_indices[k].begin(),
+                       block_indices[k].end());
+        values.insert(values.end(), block_values[k].begin(),
+                      block_values[k].end());
+    }
+    return SparseMatrix<Value>(A.rows(), B.cols(), std::move(offsets),
+                               std::move(indices), std::move(values));
+}
+
+// add over every stored value
+template <class Semiring>
+typename Semiring::value_type reduce(
+    const SparseMatrix<typename Semiring::value_type>& A) {
+    auto acc = Semiring::zero();
+    for (auto x : A.values()) acc = Semiring::add(acc, x);
+    return acc;
+}
+
+}  // namespace graph_sdk
+#endif
@@ -0,0 +1,107 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_TOPOLOGICAL_LEVELS_H
+#define GRAPH_SDK_TOPOLOGICAL_LEVELS_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "../include/csr.h"
+#include "../include/parallel.h"
+
+namespace graph_sdk {
+
+// Execution wavefronts in CSR form: level l is
+// nodes[offsets[l] .. offsets[l + 1]), sorted ascending, and every node
+// only depends on nodes of earlier levels. Nodes on a cycle, or downstream
+// of one, never become ready and are listed in leftover.
+struct TopologicalLevels {
+    std::vector<size_t> offsets{0};
+    std::vector<size_t> nodes{};
+    std::vector<size_t> leftover{};
+
+    size_t level_num() const { return offsets.size() - 1; }
+    Range<size_t> level(size_t l) const {
+        return Range<size_t>(nodes.data() + offsets[l],
+                             nodes.data() + offsets[l + 1]);
+    }
+    bool is_dag() const { return leftover.empty(); }
+};
+
+// Level-parallel Kahn: in-degrees are atomic counters, every chunk of the
+// current level collects the nodes it releases in its own buffer and the
+// buffers are merged and sorted into the next level.
+template <class Graph>
+TopologicalLevels topological_levels(
+    const Graph& graph,
+    const ExecutionPolicy& policy = ExecutionPolicy::seq()) {
+    using NodeId = typename Graph::node_type;
+    const auto V = graph.node_num();
+    const size_t grain = 4096;
+    std::unique_ptr<std::atomic<NodeId>[]> in_degree(
+        new std::atomic<NodeId>[V]);
+    parallel_for(policy, 0, V, grain, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i)
+            in_degree[i].store(0, std::memory_order_relaxed);
+    });
+    parallel_for(policy, 0, V, grain, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            for (auto x : graph.neighbours(i))
+                in_degree[x].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    TopologicalLevels levels{};
+    levels.nodes.reserve(V);
+    std::vector<std::vector<size_t>> buffers((V + grain - 1) / grain);
+    // appends the buffers as the next level
+    auto merge = [&]() {
+        const auto begin = levels.nodes.size();
+        for (auto& buffer : buffers) {
+            levels.nodes.insert(levels.nodes.end(), buffer.begin(),
+                                buffer.end());
+            buffer.clear();
+        }
+        std::sort(levels.nodes.begin() + begin, levels.nodes.end());
+        if (levels.nodes.size() > begin)
+            levels.offsets.push_back(levels.nodes.size());
+    };
+
+    parallel_for(policy, 0, V, grain, [&](size_t b, size_t e) {
+        auto& buffer = buffers[b / grain];
+        for (size_t i = b; i < e; ++i) {
+            if (in_degree[i].load(std::memory_order_relaxed) == 0)
+                buffer.push_back(i);
+        }
+    });
+    merge();
+
+    for (size_t first = 0; first < levels.nodes.size();) {
+        const auto last = levels.nodes.size();
+        parallel_for(policy, first, last, grain, [&](size_t b, size_t e) {
+            auto& buffer = buffers[(b - first) / grain];
+            for (size_t f = b; f < e; ++f) {
+                for (auto x : graph.neighbours(levels.nodes[f])) {
+                    auto left = in_degree[x].fetch_sub(
+                        1, std::memory_order_acq_rel);
+                    if (left == 1) buffer.push_back(x);
+                }
+            }
+        });
+        merge();
+        first = last;
+    }
+
+    if (levels.nodes.size() != V) {
+        for (size_t i = 0; i < V; ++i) {
+            if (in_degree[i].load(std::memory_order_relaxed) != 0)
+                levels.leftover.push_back(i);
+        }
+    }
+    return levels;
+}
+
+}  // namespace graph_sdk
+#endif
@@ -14,7 +14,7 @@ template <typename Container>
 void print_elem(const Container& container) {
     std::for_each(container.begin(), container.end(),
                   [](const auto& x) { std::cout << x << ' '; });
-    std::cout << std::endl;
+    std::cout << '\n';
 }
 
 template <typename Container2d>
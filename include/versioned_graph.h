@@ -0,0 +1,135 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_VERSIONED_GRAPH_H
+#define GRAPH_SDK_VERSIONED_GRAPH_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../include/csr.h"
+#include "../include/graph.h"
+
+namespace graph_sdk {
+
+// Epoch based reclamation. A reader announces the global epoch in a slot
+// before it reads a shared pointer; an object retired at epoch e is freed
+// once every announced epoch is above e.
+class EpochDomain {
+   private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> used{false};
+    };
+    std::atomic<uint64_t> global_{1};
+    std::unique_ptr<Slot[]> slots_{};
+    size_t slot_num_{};
+
+   public:
+    explicit EpochDomain(size_t slots);
+
+    // pin / unpin a reader slot
+    size_t enter();
+    void leave(size_t slot);
+    // epoch to tag an object unlinked just before the call
+    uint64_t retire_epoch();
+    // smallest epoch still announced, max when no reader is active
+    uint64_t min_active() const;
+};
+
+// Multi-version graph: one writer, any number of readers. Rows are sorted
+// vectors grouped in pages of row pointers; a commit publishes a version
+// that shares every untouched page and row with its predecessor, so the
+// writer copies only what it changed. Readers pin a snapshot which stays
+// valid and immutable until it is destroyed.
+class VersionedGraph {
+   public:
+    using Row = std::vector<size_t>;
+
+   private:
+    static constexpr size_t page_size = 1024;
+    using Page = std::vector<std::shared_ptr<Row>>;
+    struct Version {
+        std::vector<std::shared_ptr<Page>> pages{};
+        size_t node_num{};
+        size_t edge_num{};
+        size_t id{};
+    };
+    struct Retired {
+        uint64_t epoch{};
+        const Version* version{};
+    };
+
+    mutable EpochDomain epochs_;
+    std::atomic<const Version*> current_{nullptr};
+    std::mutex writer_{};
+    // changes since the last commit, pages and rows in fresh_* are private
+    std::unique_ptr<Version> pending_{};
+    std::vector<char> fresh_pages_{};
+    std::unordered_set<size_t> fresh_rows_{};
+    std::shared_ptr<Row> empty_row_{std::make_shared<Row>()};
+    std::vector<Retired> retired_{};
+
+    void begin_pending();
+    Row& writable_row(size_t v);
+    void grow(size_t node_num);
+    void reclaim();
+
+   public:
+    class Snapshot {
+       private:
+        const Version* version_{};
+        EpochDomain* epochs_{};
+        size_t slot_{};
+
+        friend class VersionedGraph;
+        Snapshot(const Version* version, EpochDomain* epochs, size_t slot)
+            : version_(version), epochs_(epochs), slot_(slot) {}
+
+       public:
+        using node_type = size_t;
+
+        Snapshot(Snapshot&& other) noexcept
+            : version_(std::exchange(other.version_, nullptr)),
+              epochs_(other.epochs_),
+              slot_(other.slot_) {}
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot& operator=(Snapshot&&) = delete;
+        ~Snapshot() {
+            if (version_) epochs_->leave(slot_);
+        }
+
+        size_t version() const { return version_->id; }
+        size_t node_num() const { return version_->node_num; }
+        size_t edge_num() const { return version_->edge_num; }
+        Range<size_t> neighbours(size_t v) const {
+            const auto& row = *(*version_->pages[v / page_size])[v % page_size];
+            return Range<size_t>(row.data(), row.data() + row.size());
+        }
+        bool has_edge(size_t u, size_t v) const;
+        DirectedGraph to_graph() const;
+    };
+
+    explicit VersionedGraph(const DirectedGraph& graph = DirectedGraph{},
+                            size_t reader_slots = 256);
+    ~VersionedGraph();
+    VersionedGraph(const VersionedGraph&) = delete;
+    VersionedGraph& operator=(const VersionedGraph&) = delete;
+
+    // Writer side; changes become visible to new snapshots on commit().
+    bool add_edge(std::pair<size_t, size_t> arrow);
+    bool remove_edge(std::pair<size_t, size_t> arrow);
+    // returns the id of the published version
+    size_t commit();
+
+    // Reader side; blocks only when every reader slot is taken.
+    Snapshot snapshot() const;
+};
+
+}  // namespace graph_sdk
+#endif
@@ -0,0 +1,74 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#ifndef GRAPH_SDK_WORKSPACE_H
+#define GRAPH_SDK_WORKSPACE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace graph_sdk {
+
+// Array whose entries read as T{} after reset(); a generation stamp makes
+// reset O(1), only a stamp wrap-around clears the whole array.
+template <typename T>
+class StampedArray {
+   private:
+    std::vector<T> values_{};
+    std::vector<uint32_t> stamps_{};
+    uint32_t generation_{0};
+
+   public:
+    void reset(size_t n) {
+        if (stamps_.size() < n) {
+            stamps_.resize(n, 0);
+            values_.resize(n);
+        }
+        if (++generation_ == 0) {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            generation_ = 1;
+        }
+    }
+
+    T get(size_t i) const {
+        return stamps_[i] == generation_ ? values_[i] : T{};
+    }
+
+    void set(size_t i, T value) {
+        stamps_[i] = generation_;
+        values_[i] = value;
+    }
+};
+
+// Scratch buffers kept by the caller across calls of the workspace
+// overloads of dfs, has_cycle, topological_sort, extract_scc, is_reachable
+// and shortest_path. Once the buffers have grown to the graph size those
+// calls do not allocate.
+struct Workspace {
+    using Frame = std::pair<size_t, std::set<size_t>::const_iterator>;
+
+    StampedArray<unsigned char> state{};
+    StampedArray<size_t> index{};
+    StampedArray<size_t> low{};
+    std::vector<size_t> stack{};
+    std::vector<Frame> frames{};
+    // the second frontier of a bidirectional search and the level being
+    // built, stack holds the first
+    std::vector<size_t> frontier{};
+    std::vector<size_t> next{};
+
+    void reset(size_t n) {
+        state.reset(n);
+        index.reset(n);
+        low.reset(n);
+        stack.clear();
+        frames.clear();
+        frontier.clear();
+        next.clear();
+    }
+};
+
+}  // namespace graph_sdk
+#endif
@@ -0,0 +1,105 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <type_traits>
+
+#include "../include/armadillo_bridge.h"
+#include "../include/csr.h"
+#include "../include/instrument.h"
+
+namespace graph_sdk {
+
+namespace {
+// column pointers and row indices of the transposed adjacency
+template <class Csr>
+std::pair<arma::uvec, arma::uvec> column_arrays(const Csr& in_edges) {
+    arma::uvec rows(in_edges.edge_num()), columns(in_edges.node_num() + 1);
+    std::copy(in_edges.targets().begin(), in_edges.targets().end(),
+              rows.begin());
+    std::copy(in_edges.offsets().begin(), in_edges.offsets().end(),
+              columns.begin());
+    return std::make_pair(std::move(rows), std::move(columns));
+}
+}  // namespace
+
+arma::sp_mat to_armadillo(const DirectedGraph& graph) {
+    return graph.with_cached_csr([](const auto& csr) {
+        const auto in_edges = csr.reverse();
+        const auto V = in_edges.node_num();
+        auto [rows, columns] = column_arrays(in_edges);
+        arma::vec values(in_edges.edge_num(), arma::fill::ones);
+        return arma::sp_mat(rows, columns, values, V, V);
+    });
+}
+
+arma::sp_mat to_armadillo(const DiWeightedGraph& graph) {
+    return graph.with_cached_csr([&](const auto& csr) {
+        const auto in_edges = csr.reverse();
+        const auto V = in_edges.node_num();
+        auto [rows, columns] = column_arrays(in_edges);
+        const auto& weighted = graph.extract_weighted_edges();
+        arma::vec values(in_edges.edge_num());
+        for (size_t j = 0; j < V; ++j) {
+            for (auto e = in_edges.offsets()[j];
+                 e < in_edges.offsets()[j + 1]; ++e)
+                values[e] = weighted.at({size_t(in_edges.targets()[e]), j});
+        }
+        return arma::sp_mat(rows, columns, values, V, V);
+    });
+}
+
+arma::sp_mat armadillo_laplacian(const DirectedGraph& graph) {
+    return graph.with_cached_csr([](const auto& csr) {
+        using NodeId = typename std::decay_t<decltype(csr)>::node_type;
+        const auto undirected = symmetrize(csr);
+        const auto V = undirected.node_num();
+        arma::uvec rows(undirected.edge_num() + V), columns(V + 1);
+        arma::vec values(undirected.edge_num() + V);
+        arma::uword k = 0;
+        columns[0] = 0;
+        for (size_t v = 0; v < V; ++v) {
+            auto column = undirected.neighbours(v);
+            auto split =
+                std::lower_bound(column.begin(), column.end(), NodeId(v));
+            for (auto it = column.begin(); it != split; ++it, ++k) {
+                rows[k] = *it;
+                values[k] = -1.0;
+            }
+            rows[k] = v;
+            values[k++] = double(column.size());
+            for (auto it = split; it != column.end(); ++it, ++k) {
+                rows[k] = *it;
+                values[k] = -1.0;
+            }
+            columns[v + 1] = k;
+        }
+        return arma::sp_mat(rows, columns, values, V, V);
+    });
+}
+
+std::pair<bool, arma::mat> armadillo_spectral_embedding(
+    const DirectedGraph& graph, size_t dimensions) {
+    GRAPH_SDK_RECORD("armadillo_spectral_embedding");
+    const auto L = armadillo_laplacian(graph);
+    const auto V = size_t(L.n_rows);
+    const auto wanted = std::min(dimensions + 1, V);
+    if (wanted <= 1) return std::make_pair(true, arma::mat(V, 0));
+    // eigs_sym needs fewer eigenvalues than rows
+    if (wanted == V) {
+        arma::vec lambda{};
+        arma::mat vectors{};
+        if (!arma::eig_sym(lambda, vectors, arma::mat(L)))
+            return std::make_pair(false, arma::mat{});
+        return std::make_pair(true, arma::mat(vectors.cols(1, V - 1)));
+    }
+    arma::vec lambda{};
+    arma::mat vectors{};
+    if (!arma::eigs_sym(lambda, vectors, L, wanted, "sa"))
+        return std::make_pair(false, arma::mat{});
+    arma::uvec order = arma::sort_index(lambda);
+    arma::mat coordinates(V, wanted - 1);
+    for (size_t k = 1; k < wanted; ++k)
+        coordinates.col(k - 1) = vectors.col(order[k]);
+    return std::make_pair(true, coordinates);
+}
+}  // namespace graph_sdk
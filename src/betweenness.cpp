@@ -0,0 +1,314 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <random>
+
+#include "../include/betweenness.h"
+#include "../include/csr.h"
+#include "../include/instrument.h"
+
+namespace graph_sdk {
+
+namespace {
+// Dependencies are summed in 2^-40 fixed point: integer addition is
+// associative, so per-thread accumulators give the same totals whatever
+// the thread count and the order in which sources were claimed.
+using Fixed = __int128;
+constexpr double fixed_one = 1099511627776.0;
+
+Fixed to_fixed(double x) { return Fixed(x * fixed_one + 0.5); }
+double from_fixed(Fixed x) { return double(x) / fixed_one; }
+
+constexpr int64_t unreached = std::numeric_limits<int64_t>::max();
+
+struct Scratch {
+    std::vector<int64_t> distance{};
+    std::vector<double> sigma{};
+    std::vector<double> delta{};
+    // reached nodes by non-decreasing distance
+    std::vector<size_t> order{};
+
+    explicit Scratch(size_t V)
+        : distance(V, unreached), sigma(V, 0.0), delta(V, 0.0) {}
+
+    void reset() {
+        for (auto v : order) {
+            distance[v] = unreached;
+            sigma[v] = delta[v] = 0.0;
+        }
+        order.clear();
+    }
+};
+
+// Successors on shortest paths are recognised by their distance, so no
+// predecessor lists are stored.
+template <class Graph>
+void bfs_dependencies(const Graph& graph, size_t source, Scratch& s) {
+    s.distance[source] = 0;
+    s.sigma[source] = 1.0;
+    s.order.push_back(source);
+    for (size_t head = 0; head < s.order.size(); ++head) {
+        auto v = s.order[head];
+        for (auto w : graph.neighbours(v)) {
+            if (s.distance[w] == unreached) {
+                s.distance[w] = s.distance[v] + 1;
+                s.order.push_back(w);
+            }
+            if (s.distance[w] == s.distance[v] + 1) s.sigma[w] += s.sigma[v];
+        }
+    }
+    for (auto i = s.order.size(); i-- > 0;) {
+        auto v = s.order[i];
+        double dependency = 0.0;
+        for (auto w : graph.neighbours(v)) {
+            if (s.distance[w] == s.distance[v] + 1)
+                dependency += s.sigma[v] / s.sigma[w] * (1.0 + s.delta[w]);
+        }
+        s.delta[v] = dependency;
+    }
+}
+
+// weights[e] belongs to graph.targets()[e]
+template <class Graph>
+void dijkstra_dependencies(const Graph& graph,
+                           const std::vector<int64_t>& weights,
+                           size_t source, Scratch& s) {
+    using Entry = std::pair<int64_t, size_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>
+        heap{};
+    const auto& offsets = graph.offsets();
+    const auto& targets = graph.targets();
+    s.distance[source] = 0;
+    s.sigma[source] = 1.0;
+    heap.emplace(0, source);
+    while (!heap.empty()) {
+        auto [d, v] = heap.top();
+        heap.pop();
+        // a node is pushed once per strict improvement
+        if (d != s.distance[v]) continue;
+        s.order.push_back(v);
+        for (auto e = offsets[v]; e < offsets[v + 1]; ++e) {
+            auto w = targets[e];
+            auto candidate = d + weights[e];
+            if (candidate < s.distance[w]) {
+                s.distance[w] = candidate;
+                s.sigma[w] = s.sigma[v];
+                heap.emplace(candidate, w);
+            } else if (candidate == s.distance[w]) {
+                s.sigma[w] += s.sigma[v];
+            }
+        }
+    }
+    for (auto i = s.order.size(); i-- > 0;) {
+        auto v = s.order[i];
+        double dependency = 0.0;
+        for (auto e = offsets[v]; e < offsets[v + 1]; ++e) {
+            auto w = targets[e];
+            if (s.distance[v] + weights[e] == s.distance[w])
+                dependency += s.sigma[v] / s.sigma[w] * (1.0 + s.delta[w]);
+        }
+        s.delta[v] = dependency;
+    }
+}
+
+using Dependencies = std::function<void(size_t, Scratch&)>;
+
+// Adds scale * delta_s(v) of every source into sum, and its square into
+// squares when given. Threads claim blocks of sources and keep private
+// accumulators that are added up at the end.
+void accumulate(size_t V, const std::vector<size_t>& sources, double scale,
+                const Dependencies& dependencies, std::vector<Fixed>& sum,
+                std::vector<Fixed>* squares, const ExecutionPolicy& policy) {
+    const size_t block = 16;
+    const size_t blocks = (sources.size() + block - 1) / block;
+    const auto workers =
+        std::min(policy.threads(), std::max<size_t>(blocks, 1));
+    std::vector<std::vector<Fixed>> partial(workers), partial_squares(workers);
+    std::atomic<size_t> next{0};
+    run_workers(policy, workers, [&](size_t worker) {
+        Scratch scratch(V);
+        auto& local = partial[worker];
+        auto& local_squares = partial_squares[worker];
+        local.assign(V, 0);
+        if (squares) local_squares.assign(V, 0);
+        for (auto c = next.fetch_add(1); c < blocks; c = next.fetch_add(1)) {
+            auto end = std::min(sources.size(), (c + 1) * block);
+            for (auto i = c * block; i < end; ++i) {
+                auto source = sources[i];
+                dependencies(source, scratch);
+                for (auto v : scratch.order) {
+                    if (v == source) continue;
+                    auto x = scratch.delta[v] * scale;
+                    local[v] += to_fixed(x);
+                    if (squares) local_squares[v] += to_fixed(x * x);
+                }
+                scratch.reset();
+            }
+        }
+    });
+    for (size_t w = 0; w < workers; ++w) {
+        if (partial[w].empty()) continue;
+        for (size_t v = 0; v < V; ++v) sum[v] += partial[w][v];
+        if (!squares) continue;
+        for (size_t v = 0; v < V; ++v) (*squares)[v] += partial_squares[w][v];
+    }
+}
+
+std::vector<double> exact(size_t V, const Dependencies& dependencies,
+                          const ExecutionPolicy& policy) {
+    std::vector<size_t> sources(V);
+    std::iota(sources.begin(), sources.end(), 0);
+    std::vector<Fixed> sum(V, 0);
+    accumulate(V, sources, 1.0, dependencies, sum, nullptr, policy);
+    std::vector<double> centrality(V);
+    for (size_t v = 0; v < V; ++v) centrality[v] = from_fixed(sum[v]);
+    return centrality;
+}
+
+// X_s(v) = delta_s(v) / (V - 2) lies in [0, 1] and has mean
+// b(v) / (V (V - 2)). Half of delta goes to the Hoeffding cap, the other
+// half is split over the checkpoints; each bound is two-sided and taken
+// over all V nodes.
+BetweennessEstimate estimate(size_t V, const Dependencies& dependencies,
+                             double epsilon, double delta, unsigned seed,
+                             const ExecutionPolicy& policy) {
+    assert(epsilon > 0.0 && delta > 0.0 && delta < 1.0);
+    BetweennessEstimate result{};
+    if (V < 3) {
+        result.centrality.assign(V, 0.0);
+        return result;
+    }
+    const auto cap = std::max<size_t>(
+        2, size_t(std::ceil(std::log(4.0 * double(V) / delta) /
+                            (2.0 * epsilon * epsilon))));
+    if (cap >= V) {
+        result.centrality = exact(V, dependencies, policy);
+        result.samples = V;
+        return result;
+    }
+    const size_t first = std::min<size_t>(cap, 64);
+    size_t checks = 1;
+    for (auto n = first; n < cap; n *= 2) ++checks;
+    const double bernstein_log =
+        std::log(4.0 * double(V) * 2.0 * double(checks) / delta);
+
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<size_t> uniform(0, V - 1);
+    const double scale = 1.0 / double(V - 2);
+    std::vector<Fixed> sum(V, 0), squares(V, 0);
+    std::vector<size_t> sources{};
+    size_t n = 0;
+    for (auto target = first;; target = std::min(cap, 2 * target)) {
+        sources.clear();
+        for (; n < target; ++n) sources.push_back(uniform(rng));
+        accumulate(V, sources, scale, dependencies, sum, &squares, policy);
+
+        double error = 0.0;
+        for (size_t v = 0; v < V; ++v) {
+            auto mean = from_fixed(sum[v]) / double(n);
+            auto variance = std::max(
+                0.0, (from_fixed(squares[v]) - double(n) * mean * mean) /
+                         double(n - 1));
+            auto bound = std::sqrt(2.0 * variance * bernstein_log / double(n)) +
+                         7.0 * bernstein_log / (3.0 * double(n - 1));
+            error = std::max(error, bound);
+        }
+        if (n == cap) {
+            auto hoeffding = std::sqrt(std::log(4.0 * double(V) / delta) /
+                                       (2.0 * double(n)));
+            error = std::min(error, hoeffding);
+        }
+        if (error <= epsilon || n == cap) {
+            result.error = error;
+            break;
+        }
+    }
+    result.samples = n;
+    result.centrality.resize(V);
+    const double factor = double(V) * double(V - 2) / double(n);
+    for (size_t v = 0; v < V; ++v)
+        result.centrality[v] = from_fixed(sum[v]) * factor;
+    return result;
+}
+
+template <class Graph>
+std::vector<int64_t> edge_weights(const DiWeightedGraph& graph,
+                                  const Graph& csr) {
+    const auto& weighted = graph.extract_weighted_edges();
+    std::vector<int64_t> weights(csr.edge_num());
+    for (size_t v = 0; v < csr.node_num(); ++v) {
+        for (auto e = csr.offsets()[v]; e < csr.offsets()[v + 1]; ++e) {
+            weights[e] = weighted.at({v, size_t(csr.targets()[e])});
+            assert(weights[e] > 0);
+        }
+    }
+    return weights;
+}
+}  // namespace
+
+std::vector<double> betweenness_centrality(const DirectedGraph& graph,
+                                           const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("betweenness_centrality");
+    return graph.with_cached_csr([&](const auto& csr) {
+        return exact(
+            csr.node_num(),
+            [&](size_t s, Scratch& scratch) {
+                bfs_dependencies(csr, s, scratch);
+            },
+            policy);
+    });
+}
+
+std::vector<double> betweenness_centrality(const DiWeightedGraph& graph,
+                                           const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("weighted_betweenness_centrality");
+    return graph.with_cached_csr([&](const auto& csr) {
+        const auto weights = edge_weights(graph, csr);
+        return exact(
+            csr.node_num(),
+            [&](size_t s, Scratch& scratch) {
+                dijkstra_dependencies(csr, weights, s, scratch);
+            },
+            policy);
+    });
+}
+
+BetweennessEstimate approximate_betweenness(const DirectedGraph& graph,
+                                            double epsilon, double delta,
+                                            unsigned seed,
+                                            const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("approximate_betweenness");
+    return graph.with_cached_csr([&](const auto& csr) {
+        return estimate(
+            csr.node_num(),
+            [&](size_t s, Scratch& scratch) {
+                bfs_dependencies(csr, s, scratch);
+            },
+            epsilon, delta, seed, policy);
+    });
+}
+
+BetweennessEstimate approximate_betweenness(const DiWeightedGraph& graph,
+                                            double epsilon, double delta,
+                                            unsigned seed,
+                                            const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("weighted_approximate_betweenness");
+    return graph.with_cached_csr([&](const auto& csr) {
+        const auto weights = edge_weights(graph, csr);
+        return estimate(
+            csr.node_num(),
+            [&](size_t s, Scratch& scratch) {
+                dijkstra_dependencies(csr, weights, s, scratch);
+            },
+            epsilon, delta, seed, policy);
+    });
+}
+}  // namespace graph_sdk
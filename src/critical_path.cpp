@@ -0,0 +1,214 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "../include/critical_path.h"
+#include "../include/instrument.h"
+
+namespace graph_sdk {
+
+CriticalPath::CriticalPath(const DiWeightedGraph& graph,
+                           const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("critical_path");
+    is_wide_ = !graph.fits_csr32();
+    if (is_wide_)
+        build(wide_, graph, policy);
+    else
+        build(narrow_, graph, policy);
+}
+
+template <typename NodeId, typename EdgeId>
+void CriticalPath::build(Topology<NodeId, EdgeId>& topology,
+                         const DiWeightedGraph& graph,
+                         const ExecutionPolicy& policy) {
+    auto& forward = topology.forward;
+    forward = graph.to_csr<NodeId, EdgeId>();
+    const auto V = forward.node_num();
+    const auto E = forward.edge_num();
+    auto levels = topological_levels(forward, policy);
+    if (!levels.is_dag()) return;
+    is_dag_ = true;
+
+    const auto& weights = graph.extract_weighted_edges();
+    forward_weight_.resize(E);
+    for (size_t u = 0; u < V; ++u) {
+        for (auto e = forward.offsets()[u]; e < forward.offsets()[u + 1];
+             ++e) {
+            auto it = weights.find({u, forward.targets()[e]});
+            assert(it != weights.end());
+            forward_weight_[e] = it->second;
+        }
+    }
+
+    // transpose by counting sort, carrying the weights along
+    std::vector<EdgeId> offsets(V + 1, 0);
+    for (auto x : forward.targets()) offsets[x + 1] += 1;
+    for (size_t i = 0; i < V; ++i) offsets[i + 1] += offsets[i];
+    std::vector<NodeId> targets(E);
+    std::vector<EdgeId> fill(offsets.begin(), offsets.end() - 1);
+    backward_weight_.resize(E);
+    topology.mirror.resize(E);
+    for (size_t u = 0; u < V; ++u) {
+        for (auto e = forward.offsets()[u]; e < forward.offsets()[u + 1];
+             ++e) {
+            auto position = fill[forward.targets()[e]]++;
+            targets[position] = NodeId(u);
+            backward_weight_[position] = forward_weight_[e];
+            topology.mirror[e] = position;
+        }
+    }
+    topology.backward =
+        CsrGraph<NodeId, EdgeId>(std::move(offsets), std::move(targets));
+
+    level_.resize(V);
+    for (size_t l = 0; l < levels.level_num(); ++l) {
+        for (auto v : levels.level(l)) level_[v] = l;
+    }
+    head_.assign(V, 0);
+    tail_.assign(V, 0);
+    {
+        GRAPH_SDK_PHASE("relax");
+        for (size_t l = 0; l < levels.level_num(); ++l) {
+            auto nodes = levels.level(l);
+            parallel_for(policy, 0, nodes.size(), 1024,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i)
+                                 head_[nodes[i]] =
+                                     pull_head(topology, nodes[i]);
+                         });
+        }
+        for (size_t l = levels.level_num(); l-- > 0;) {
+            auto nodes = levels.level(l);
+            parallel_for(policy, 0, nodes.size(), 1024,
+                         [&](size_t b, size_t e) {
+                             for (size_t i = b; i < e; ++i)
+                                 tail_[nodes[i]] =
+                                     pull_tail(topology, nodes[i]);
+                         });
+        }
+        GRAPH_SDK_COUNT_VERTICES(2 * V);
+        GRAPH_SDK_COUNT_EDGES(2 * E);
+    }
+
+    span_.assign(2 * V, 0);
+    std::copy(head_.begin(), head_.end(), span_.begin() + V);
+    for (size_t i = V; i-- > 1;)
+        span_[i] = std::max(span_[2 * i], span_[2 * i + 1]);
+}
+
+template <typename NodeId, typename EdgeId>
+int64_t CriticalPath::pull_head(const Topology<NodeId, EdgeId>& topology,
+                                size_t v) const {
+    const auto& backward = topology.backward;
+    if (backward.degree(v) == 0) return 0;
+    auto value = std::numeric_limits<int64_t>::min();
+    for (auto e = backward.offsets()[v]; e < backward.offsets()[v + 1]; ++e)
+        value = std::max(value,
+                         head_[backward.targets()[e]] + backward_weight_[e]);
+    return value;
+}
+
+template <typename NodeId, typename EdgeId>
+int64_t CriticalPath::pull_tail(const Topology<NodeId, EdgeId>& topology,
+                                size_t v) const {
+    const auto& forward = topology.forward;
+    if (forward.degree(v) == 0) return 0;
+    auto value = std::numeric_limits<int64_t>::min();
+    for (auto e = forward.offsets()[v]; e < forward.offsets()[v + 1]; ++e)
+        value =
+            std::max(value, forward_weight_[e] + tail_[forward.targets()[e]]);
+    return value;
+}
+
+void CriticalPath::update_span(size_t v) {
+    auto i = v + head_.size();
+    span_[i] = head_[v];
+    for (i /= 2; i >= 1; i /= 2)
+        span_[i] = std::max(span_[2 * i], span_[2 * i + 1]);
+}
+
+std::vector<size_t> CriticalPath::critical_path() const {
+    return is_wide_ ? critical_path(wide_) : critical_path(narrow_);
+}
+
+template <typename NodeId, typename EdgeId>
+std::vector<size_t> CriticalPath::critical_path(
+    const Topology<NodeId, EdgeId>& topology) const {
+    const auto& forward = topology.forward;
+    std::vector<size_t> path{};
+    const auto V = head_.size();
+    size_t curr = 0;
+    while (curr < V &&
+           (topology.backward.degree(curr) != 0 || slack(curr) != 0))
+        ++curr;
+    if (!is_dag_ || curr == V) return path;
+
+    path.push_back(curr);
+    while (forward.degree(curr) != 0) {
+        for (auto e = forward.offsets()[curr]; e < forward.offsets()[curr + 1];
+             ++e) {
+            size_t x = forward.targets()[e];
+            if (forward_weight_[e] + tail_[x] == tail_[curr]) {
+                curr = x;
+                break;
+            }
+        }
+        path.push_back(curr);
+    }
+    return path;
+}
+
+bool CriticalPath::update_weight(size_t u, size_t v, int weight) {
+    GRAPH_SDK_RECORD("critical_path_update");
+    if (!is_dag_ || u >= head_.size()) return false;
+    return is_wide_ ? update_weight(wide_, u, v, weight)
+                    : update_weight(narrow_, u, v, weight);
+}
+
+// Heads change only downstream of v and tails only upstream of u; both are
+// refreshed in level order and stop spreading where a value stays the same.
+template <typename NodeId, typename EdgeId>
+bool CriticalPath::update_weight(const Topology<NodeId, EdgeId>& topology,
+                                 size_t u, size_t v, int weight) {
+    const auto& forward = topology.forward;
+    auto row = forward.neighbours(u);
+    auto it = std::lower_bound(row.begin(), row.end(), v);
+    if (it == row.end() || *it != v) return false;
+    auto e = forward.offsets()[u] + (it - row.begin());
+    forward_weight_[e] = weight;
+    backward_weight_[topology.mirror[e]] = weight;
+
+    using Item = std::pair<size_t, size_t>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> down{};
+    down.push({level_[v], v});
+    while (!down.empty()) {
+        auto x = down.top().second;
+        down.pop();
+        GRAPH_SDK_COUNT_VERTICES(1);
+        auto value = pull_head(topology, x);
+        if (value == head_[x]) continue;
+        head_[x] = value;
+        update_span(x);
+        for (auto y : forward.neighbours(x)) down.push({level_[y], y});
+    }
+
+    std::priority_queue<Item> up{};
+    up.push({level_[u], u});
+    while (!up.empty()) {
+        auto x = up.top().second;
+        up.pop();
+        GRAPH_SDK_COUNT_VERTICES(1);
+        auto value = pull_tail(topology, x);
+        if (value == tail_[x]) continue;
+        tail_[x] = value;
+        for (auto y : topology.backward.neighbours(x))
+            up.push({level_[y], y});
+    }
+    return true;
+}
+}  // namespace graph_sdk
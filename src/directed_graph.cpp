@@ -15,6 +15,7 @@
 #include <utility>
 
 #include "../include/graph.h"
+#include "../include/instrument.h"
 #include "../include/utils.h"
 
 namespace graph_sdk {
@@ -53,6 +54,7 @@ DirectedGraph::DirectedGraph(const Matrix<size_t>& matrix) {
 
 void DirectedGraph::random_generate(size_t V, size_t D) {
     srand(time(NULL));
+    ++version_;
     adjacency_.assign(V, std::set<size_t>{});
     VN_ = V;
     EN_ = 0;
@@ -69,6 +71,7 @@ void DirectedGraph::random_generate(size_t V, size_t D) {
 }
 // modification
 bool DirectedGraph::add_edge(std::pair<size_t, size_t> arrow) {
+    ++version_;
     if (auto max_tmp = std::max(arrow.first, arrow.second); max_tmp >= VN_) {
         adjacency_.resize(max_tmp + 1);
     }
@@ -80,6 +83,7 @@ bool DirectedGraph::add_edge(std::pair<size_t, size_t> arrow) {
 
 bool DirectedGraph::remove_node(size_t idx) {
     if (idx >= VN_) return false;
+    ++version_;
 
     if (idx == VN_ - 1) {
         adjacency_.resize(idx);
@@ -101,6 +105,7 @@ bool DirectedGraph::remove_node(size_t idx) {
 
 bool DirectedGraph::remove_edge(std::pair<size_t, size_t> arrow) {
     if (arrow.first >= VN_) return false;
+    ++version_;
     if (auto it = adjacency_[arrow.first].find(arrow.second);
         it != adjacency_[arrow.first].end()) {
         adjacency_[arrow.first].erase(it);
@@ -112,6 +117,7 @@ bool DirectedGraph::remove_edge(std::pair<size_t, size_t> arrow) {
 
 bool DirectedGraph::random_remove_edges(size_t n) {
     if (n > EN_) return false;
+    ++version_;
     Edges edges = DirectedGraph::extract_edges();
 
     auto rd = std::random_device{};
@@ -130,6 +136,7 @@ bool DirectedGraph::random_remove_edges(size_t n) {
 
 void DirectedGraph::exchange_nodes(size_t n1, size_t n2) {
     assert(std::max(n1, n2) < VN_);
+    ++version_;
     std::swap(adjacency_[n1], adjacency_[n2]);
 
     for (auto& x : adjacency_) {
@@ -147,6 +154,7 @@ void DirectedGraph::exchange_nodes(size_t n1, size_t n2) {
 }
 
 void DirectedGraph::reset() {
+    ++version_;
     std::vector<NodeAttribute> attributes = DirectedGraph::get_attribute();
     std::set<size_t> missed{};
     const auto N = VN_;
@@ -249,6 +257,15 @@ std::vector<NodeAttribute> DirectedGraph::get_attribute() const {
     return attribute;
 }
 
+std::vector<size_t> DirectedGraph::fetch_nodes(NodeAttribute attribute) const {
+    auto attributes = DirectedGraph::cached_attribute();
+    std::vector<size_t> nodes{};
+    for (size_t i = 0; i < VN_; ++i) {
+        if ((*attributes)[i] == attribute) nodes.push_back(i);
+    }
+    return nodes;
+}
+
 DirectedGraph DirectedGraph::reverse_graph() const {
     DirectedGraph g{VN_};
     for (auto i = 0; i < VN_; ++i) {
@@ -258,17 +275,65 @@ DirectedGraph DirectedGraph::reverse_graph() const {
 
     return g;
 }
+
+std::shared_ptr<const DirectedGraph> DirectedGraph::cached_reverse_graph()
+    const {
+    return cached(cache_.reverse, [&]() { return reverse_graph(); });
+}
+
+std::shared_ptr<const std::pair<bool, std::vector<size_t>>>
+DirectedGraph::cached_scc(const ExecutionPolicy& policy) const {
+    return cached(cache_.scc, [&]() { return extract_scc(policy); });
+}
+
+std::shared_ptr<const TopologicalLevels>
+DirectedGraph::cached_topological_levels(const ExecutionPolicy& policy) const {
+    return cached(cache_.levels,
+                  [&]() { return topological_levels(policy); });
+}
+
+std::shared_ptr<const std::vector<NodeAttribute>>
+DirectedGraph::cached_attribute() const {
+    return cached(cache_.attribute, [&]() { return get_attribute(); });
+}
+
+std::shared_ptr<const CsrGraph<>> DirectedGraph::cached_csr() const {
+    return cached(cache_.csr, [&]() { return to_csr(); });
+}
+
+std::shared_ptr<const CsrGraph<>> DirectedGraph::cached_reverse_csr() const {
+    return cached(cache_.reverse_csr, [&]() { return to_csr().reverse(); });
+}
+
+std::shared_ptr<const CsrGraph64> DirectedGraph::cached_wide_csr() const {
+    return cached(cache_.wide_csr,
+                  [&]() { return to_csr<uint64_t, uint64_t>(); });
+}
+
+std::shared_ptr<const CsrGraph64> DirectedGraph::cached_wide_reverse_csr()
+    const {
+    return cached(cache_.wide_reverse_csr, [&]() {
+        return cached_wide_csr()->reverse();
+    });
+}
+
+std::shared_ptr<const Matrix<size_t>> DirectedGraph::cached_matrix() const {
+    return cached(cache_.matrix, [&]() { return extract_matrix(); });
+}
 // depth first search related algorithms
 void DirectedGraph::dfs_helper(size_t idx, std::vector<bool>& visited,
                                std::vector<size_t>& dfs_nodes) const {
     visited[idx] = true;
     dfs_nodes.push_back(idx);
+    GRAPH_SDK_COUNT_VERTICES(1);
+    GRAPH_SDK_COUNT_EDGES(adjacency_[idx].size());
 
     for (const auto x : adjacency_[idx])
         if (!visited[x]) DirectedGraph::dfs_helper(x, visited, dfs_nodes);
 }
 
 std::vector<size_t> DirectedGraph::dfs() const {
+    GRAPH_SDK_RECORD("dfs");
     std::vector<bool> visited(VN_, false);
     std::vector<size_t> dfs_nodes{};
 
@@ -282,6 +347,8 @@ bool DirectedGraph::topo_sort_helper(size_t i,
                                      std::stack<size_t>& reverse_ordered,
                                      std::vector<size_t>& visited) const {
     visited[i] = 1;
+    GRAPH_SDK_COUNT_VERTICES(1);
+    GRAPH_SDK_COUNT_EDGES(adjacency_[i].size());
     for (const auto x : adjacency_[i]) {
         if (visited[x] == 1 ||
             (visited[x] == 0 &&
@@ -294,6 +361,7 @@ bool DirectedGraph::topo_sort_helper(size_t i,
 }
 
 std::pair<bool, std::stack<size_t>> DirectedGraph::topological_sort() const {
+    GRAPH_SDK_RECORD("topological_sort");
     std::stack<size_t> reverse_ordered{};
     std::vector<size_t> visited(VN_, 0);
     for (auto i = 0; i < VN_; ++i) {
@@ -304,10 +372,23 @@ std::pair<bool, std::stack<size_t>> DirectedGraph::topological_sort() const {
     return std::make_pair(true, reverse_ordered);
 }
 
+TopologicalLevels DirectedGraph::topological_levels(
+    const ExecutionPolicy& policy) const {
+    GRAPH_SDK_RECORD("topological_levels");
+    GRAPH_SDK_COUNT_VERTICES(VN_);
+    GRAPH_SDK_COUNT_EDGES(EN_);
+    if (CsrGraph32::fits(VN_, EN_))
+        return graph_sdk::topological_levels(DirectedGraph::to_csr(), policy);
+    return graph_sdk::topological_levels(
+        DirectedGraph::to_csr<uint64_t, uint64_t>(), policy);
+}
+
 bool DirectedGraph::has_cycle_helper(size_t idx,
                                      std::vector<size_t>& visited) const {
     // 1 for visited, 2 for done-visited
     visited[idx] = 1;
+    GRAPH_SDK_COUNT_VERTICES(1);
+    GRAPH_SDK_COUNT_EDGES(adjacency_[idx].size());
     for (const auto x : adjacency_[idx]) {
         if (visited[x] == 1 ||
             (visited[x] == 0 && DirectedGraph::has_cycle_helper(x, visited)))
@@ -318,6 +399,7 @@ bool DirectedGraph::has_cycle_helper(size_t idx,
 }
 
 bool DirectedGraph::has_cycle() const {
+    GRAPH_SDK_RECORD("has_cycle");
     std::vector<size_t> visited(adjacency_.size(), 0);
     for (size_t i = 0; i < adjacency_.size(); ++i) {
         if (visited[i] == 0 && DirectedGraph::has_cycle_helper(i, visited))
@@ -327,6 +409,7 @@ bool DirectedGraph::has_cycle() const {
 }
 
 void DirectedGraph::random_generate_dag(size_t V, size_t D) {
+    ++version_;
     auto rd = std::random_device{};
     auto rng = std::default_random_engine{rd()};
 
@@ -351,6 +434,56 @@ void DirectedGraph::random_generate_dag(size_t V, size_t D) {
     }
 }
 
+void DirectedGraph::random_generate(size_t V, size_t D,
+                                    const ExecutionPolicy& policy,
+                                    unsigned seed) {
+    ++version_;
+    adjacency_.assign(V, std::set<size_t>{});
+    VN_ = V;
+
+    // one engine per row keeps the result independent of the thread count
+    parallel_for(policy, 0, V, 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            std::seed_seq seq{seed, static_cast<unsigned>(i)};
+            std::mt19937 rng(seq);
+            for (size_t j = 0; j < V; ++j) {
+                if (i == j) continue;
+                if (rng() % V < D) adjacency_[i].insert(adjacency_[i].end(), j);
+            }
+        }
+    });
+    EN_ = DirectedGraph::calculate_edge_num();
+}
+
+void DirectedGraph::random_generate_dag(size_t V, size_t D,
+                                        const ExecutionPolicy& policy,
+                                        unsigned seed) {
+    ++version_;
+    std::mt19937 rng(seed);
+    std::vector<size_t> rank(V);
+    std::iota(rank.begin(), rank.end(), 0);
+    std::shuffle(rank.begin(), rank.end(), rng);
+    adjacency_.assign(V, std::set<size_t>{});
+    VN_ = V;
+
+    // edges only follow a hidden random order, so no cycle check is needed.
+    // Each pair gets the chance of the two attempts of random_generate_dag.
+    const double p = V > 0 ? std::min(1.0, static_cast<double>(D) / V) : 0.0;
+    const double q = 1.0 - (1.0 - p) * (1.0 - p);
+    parallel_for(policy, 0, V, 64, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            std::seed_seq seq{seed, static_cast<unsigned>(i), 1u};
+            std::mt19937 row_rng(seq);
+            std::bernoulli_distribution keep(q);
+            for (size_t j = 0; j < V; ++j) {
+                if (rank[i] < rank[j] && keep(row_rng))
+                    adjacency_[i].insert(adjacency_[i].end(), j);
+            }
+        }
+    });
+    EN_ = DirectedGraph::calculate_edge_num();
+}
+
 DirectedGraph DirectedGraph::generate_bipartite_dag() const {
     DirectedGraph graph{VN_ + EN_};
     graph.VN_ = VN_ + EN_;
@@ -386,54 +519,203 @@ DirectedGraph DirectedGraph::graph_shuffle() const {
     return graph;
 }
 
-bool DirectedGraph::extract_scc_helper(size_t i, std::vector<size_t>& visited,
-                                       std::stack<size_t>& pseudo_topo,
+// Tarjan: a component is complete when low[i] == index[i]; its members are
+// the top of the visiting stack down to i.
+bool DirectedGraph::extract_scc_helper(size_t i, size_t& counter,
+                                       std::vector<size_t>& index,
+                                       std::vector<size_t>& low,
+                                       std::vector<size_t>& visiting,
                                        std::vector<size_t>& scc) const {
     bool cyclic = false;
-    visited[i] = 1;
+    index[i] = low[i] = ++counter;
+    visiting.push_back(i);
+    GRAPH_SDK_COUNT_VERTICES(1);
+    GRAPH_SDK_COUNT_EDGES(adjacency_[i].size());
     for (const auto& x : adjacency_[i]) {
-        if (visited[x] == 0 &&
-            DirectedGraph::extract_scc_helper(x, visited, pseudo_topo, scc)) {
-            cyclic = true;
-        }
-        if ((visited[x] == 1 || visited[scc[x]] == 1) && scc[i] == i) {
-            scc[i] = scc[x];
-            cyclic = true;
+        if (index[x] == 0) {
+            if (DirectedGraph::extract_scc_helper(x, counter, index, low,
+                                                  visiting, scc))
+                cyclic = true;
+            low[i] = std::min(low[i], low[x]);
+        } else if (scc[x] == VN_) {
+            low[i] = std::min(low[i], index[x]);
         }
+        if (x == i) cyclic = true;
+    }
+    if (low[i] == index[i]) {
+        auto first =
+            std::find(visiting.rbegin(), visiting.rend(), i).base() - 1;
+        if (visiting.end() - first > 1) cyclic = true;
+        auto label = *std::min_element(first, visiting.end());
+        std::for_each(first, visiting.end(),
+                      [&](const auto& x) { scc[x] = label; });
+        visiting.erase(first, visiting.end());
     }
-    visited[i] = 2;
-    pseudo_topo.push(i);
     return cyclic;
 }
-// scc: strongly connected components
-std::pair<bool, std::vector<size_t>> DirectedGraph::extract_scc() const {
+
+// forward-backward decomposition: the component of the smallest node of a
+// partition is the intersection of its forward and backward reachable sets,
+// the three remaining parts are independent and handled by any worker.
+std::vector<size_t> DirectedGraph::extract_scc_parallel(
+    const ExecutionPolicy& policy) const {
     std::vector<size_t> scc(VN_);
-    std::vector<size_t> visited(VN_, 0);
     std::iota(scc.begin(), scc.end(), 0);
-    std::stack<size_t> pseudo_topo{};
+    std::vector<std::vector<size_t>> in_adjacency(VN_);
+    std::vector<size_t> in_degree(VN_, 0), out_degree(VN_, 0);
+    for (size_t i = 0; i < VN_; ++i) {
+        for (auto x : adjacency_[i]) {
+            in_adjacency[x].push_back(i);
+            if (x == i) continue;
+            in_degree[x] += 1;
+            out_degree[i] += 1;
+        }
+    }
 
-    bool cyclic = false;
+    // trim: nodes without in or out edges are singleton components
+    std::vector<bool> trimmed(VN_, false);
+    {
+        GRAPH_SDK_PHASE("trim");
+        std::vector<size_t> queue{};
+        for (size_t i = 0; i < VN_; ++i) {
+            if (in_degree[i] == 0 || out_degree[i] == 0) {
+                trimmed[i] = true;
+                queue.push_back(i);
+            }
+        }
+        while (!queue.empty()) {
+            auto curr = queue.back();
+            queue.pop_back();
+            auto trim = [&](size_t x, std::vector<size_t>& degree) {
+                if (trimmed[x] || x == curr) return;
+                if (--degree[x] == 0) {
+                    trimmed[x] = true;
+                    queue.push_back(x);
+                }
+            };
+            for (auto x : adjacency_[curr]) trim(x, in_degree);
+            for (auto x : in_adjacency[curr]) trim(x, out_degree);
+        }
+    }
+
+    GRAPH_SDK_PHASE("forward_backward");
+    std::unique_ptr<std::atomic<size_t>[]> color(new std::atomic<size_t>[VN_]);
+    std::vector<unsigned char> mark(VN_, 0);
+    std::atomic<size_t> color_num{1};
+    std::vector<size_t> remaining{};
     for (size_t i = 0; i < VN_; ++i) {
-        if (visited[i] == 0 && extract_scc_helper(i, visited, pseudo_topo, scc))
-            cyclic = true;
+        color[i].store(trimmed[i] ? 0 : 1, std::memory_order_relaxed);
+        if (!trimmed[i]) remaining.push_back(i);
     }
 
-    if (cyclic) {
-        while (!pseudo_topo.empty()) {
-            auto curr = pseudo_topo.top();
-            pseudo_topo.pop();
-            scc[curr] = scc[scc[curr]];
+    std::mutex mutex{};
+    std::condition_variable cv{};
+    std::vector<std::pair<size_t, std::vector<size_t>>> work{};
+    size_t active = 0;
+    if (!remaining.empty()) work.emplace_back(1, std::move(remaining));
+
+    auto reach = [&](size_t pivot, size_t c, unsigned char bit,
+                     const auto& neighbours) {
+        std::vector<size_t> stack{pivot};
+        mark[pivot] |= bit;
+        while (!stack.empty()) {
+            auto curr = stack.back();
+            stack.pop_back();
+            GRAPH_SDK_COUNT_VERTICES(1);
+            GRAPH_SDK_COUNT_EDGES(neighbours(curr).size());
+            for (auto x : neighbours(curr)) {
+                if (color[x].load(std::memory_order_relaxed) != c ||
+                    (mark[x] & bit))
+                    continue;
+                mark[x] |= bit;
+                stack.push_back(x);
+            }
+        }
+    };
+
+    auto process = [&](size_t c, std::vector<size_t>& nodes) {
+        std::vector<std::pair<size_t, std::vector<size_t>>> children{};
+        auto pivot = nodes.front();
+        if (nodes.size() > 1) {
+            reach(pivot, c, 1,
+                  [&](size_t v) -> const std::set<size_t>& {
+                      return adjacency_[v];
+                  });
+            reach(pivot, c, 2,
+                  [&](size_t v) -> const std::vector<size_t>& {
+                      return in_adjacency[v];
+                  });
+            std::vector<size_t> parts[3]{};
+            for (auto v : nodes) {
+                if (mark[v] == 3)
+                    scc[v] = pivot;
+                else
+                    parts[mark[v]].push_back(v);
+                mark[v] = 0;
+            }
+            for (auto& part : parts) {
+                if (part.empty()) continue;
+                auto new_color = color_num.fetch_add(1) + 1;
+                for (auto v : part)
+                    color[v].store(new_color, std::memory_order_relaxed);
+                children.emplace_back(new_color, std::move(part));
+            }
+        }
+        return children;
+    };
+
+    run_workers(policy, policy.threads(), [&](size_t) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv.wait(lock, [&]() { return !work.empty() || active == 0; });
+            if (work.empty()) break;
+            auto [c, nodes] = std::move(work.back());
+            work.pop_back();
+            active += 1;
+            lock.unlock();
+            auto children = process(c, nodes);
+            lock.lock();
+            active -= 1;
+            for (auto& child : children) work.push_back(std::move(child));
+            cv.notify_all();
+        }
+    });
+    return scc;
+}
+
+// scc: strongly connected components
+std::pair<bool, std::vector<size_t>> DirectedGraph::extract_scc(
+    const ExecutionPolicy& policy) const {
+    GRAPH_SDK_RECORD("extract_scc");
+    if (policy.is_parallel()) {
+        auto scc = DirectedGraph::extract_scc_parallel(policy);
+        bool cyclic = false;
+        for (size_t i = 0; i < VN_ && !cyclic; ++i) {
+            cyclic = scc[i] != i || adjacency_[i].count(i) > 0;
         }
+        return std::make_pair(cyclic, scc);
+    }
+
+    std::vector<size_t> scc(VN_, VN_);
+    std::vector<size_t> index(VN_, 0);
+    std::vector<size_t> low(VN_, 0);
+    std::vector<size_t> visiting{};
+    size_t counter = 0;
+
+    GRAPH_SDK_PHASE("tarjan");
+    bool cyclic = false;
+    for (size_t i = 0; i < VN_; ++i) {
+        if (index[i] == 0 &&
+            extract_scc_helper(i, counter, index, low, visiting, scc))
+            cyclic = true;
     }
     return std::make_pair(cyclic, scc);
 }
 
 DirectedGraph DirectedGraph::meta_graph() const {
-    bool cyclic;
-    std::vector<size_t> scc;
-    std::tie(cyclic, scc) = DirectedGraph::extract_scc();
-    // auto [cyclic, scc] = DirectedGraph::extract_scc(); // clang bug?
-    if (!cyclic) return *this;
+    auto components = DirectedGraph::cached_scc();
+    if (!components->first) return *this;
+    const auto& scc = components->second;
 
     DirectedGraph m_graph{};
 
@@ -452,6 +734,9 @@ void DirectedGraph::extract_sc_helper(
     const std::vector<size_t>& scc,
     std::vector<std::vector<size_t>>& cycles) const {
     chain.push_back(curr);
+    valid[curr] = false;
+    GRAPH_SDK_COUNT_VERTICES(1);
+    GRAPH_SDK_COUNT_EDGES(adjacency_[curr].size());
 
     for (auto x : adjacency_[curr]) {
         if (x == chain[0]) {
@@ -462,22 +747,36 @@ void DirectedGraph::extract_sc_helper(
             DirectedGraph::extract_sc_helper(x, chain, valid, scc, cycles);
         }
     }
+    valid[curr] = true;
     chain.pop_back();
 }
 
-std::vector<std::vector<size_t>> DirectedGraph::extract_simple_cycles() const {
+// cycles are enumerated per smallest node, each start is independent
+std::vector<std::vector<size_t>> DirectedGraph::extract_simple_cycles(
+    const ExecutionPolicy& policy) const {
+    GRAPH_SDK_RECORD("extract_simple_cycles");
     std::vector<std::vector<size_t>> cycles{};
-    auto [cyclic, scc] = DirectedGraph::extract_scc();
-    if (!cyclic) return cycles;
+    auto components = DirectedGraph::cached_scc(policy);
+    if (!components->first) return cycles;
+    const auto& scc = components->second;
     // print_elem(scc);
 
-    std::vector<size_t> chain{};
-    std::vector<bool> valid(VN_, false);
-    for (size_t i = 0; i < adjacency_.size(); ++i) {
-        chain.clear();
-        std::fill_n(valid.begin(), VN_, false);
-        std::fill_n(valid.begin() + i, valid.end() - valid.begin() - i, true);
-        DirectedGraph::extract_sc_helper(i, chain, valid, scc, cycles);
+    GRAPH_SDK_PHASE("enumerate");
+    std::vector<std::vector<std::vector<size_t>>> cycles_from(VN_);
+    parallel_for(policy, 0, VN_, 1, [&](size_t begin, size_t end) {
+        std::vector<size_t> chain{};
+        std::vector<bool> valid(VN_, false);
+        for (size_t i = begin; i < end; ++i) {
+            chain.clear();
+            std::fill_n(valid.begin(), VN_, false);
+            std::fill_n(valid.begin() + i, valid.end() - valid.begin() - i,
+                        true);
+            DirectedGraph::extract_sc_helper(i, chain, valid, scc,
+                                             cycles_from[i]);
+        }
+    });
+    for (auto& x : cycles_from) {
+        std::move(x.begin(), x.end(), std::back_inserter(cycles));
     }
     return cycles;
 }
@@ -502,6 +801,244 @@ void DirectedGraph::find_path_helper(
     path.pop_back();
 }
 
+bool DirectedGraph::is_reachable(size_t source, size_t sink) const {
+    Workspace workspace{};
+    return is_reachable(workspace, source, sink);
+}
+
+std::vector<size_t> DirectedGraph::shortest_path(size_t source,
+                                                 size_t sink) const {
+    Workspace workspace{};
+    std::vector<size_t> path{};
+    shortest_path(workspace, source, sink, path);
+    return path;
+}
+
+namespace {
+// When a level expansion first reaches a node of the other side, the
+// levels seen so far were disjoint, so no path is shorter than the one
+// through that node.
+template <class Graph>
+bool bidirectional_search(const Graph& forward, const Graph& backward,
+                          Workspace& workspace, size_t source, size_t sink,
+                          std::vector<size_t>* path) {
+    const auto V = forward.node_num();
+    if (path) path->clear();
+    if (source == sink) {
+        if (path) path->push_back(source);
+        return true;
+    }
+    workspace.reset(V);
+    // parent + 1 towards source in index, child + 1 towards sink in low
+    auto& forward_frontier = workspace.stack;
+    auto& backward_frontier = workspace.frontier;
+    auto& next = workspace.next;
+    forward_frontier.push_back(source);
+    backward_frontier.push_back(sink);
+    workspace.index.set(source, source + 1);
+    workspace.low.set(sink, sink + 1);
+    size_t meet = V;
+    while (meet == V && !forward_frontier.empty() &&
+           !backward_frontier.empty()) {
+        const bool from_source =
+            forward_frontier.size() <= backward_frontier.size();
+        const auto& graph = from_source ? forward : backward;
+        auto& frontier = from_source ? forward_frontier : backward_frontier;
+        auto& own = from_source ? workspace.index : workspace.low;
+        auto& other = from_source ? workspace.low : workspace.index;
+        next.clear();
+        for (auto v : frontier) {
+            GRAPH_SDK_COUNT_EDGES(graph.degree(v));
+            for (size_t x : graph.neighbours(v)) {
+                if (own.get(x)) continue;
+                own.set(x, v + 1);
+                if (other.get(x)) {
+                    meet = x;
+                    break;
+                }
+                next.push_back(x);
+            }
+            if (meet != V) break;
+        }
+        frontier.swap(next);
+    }
+    if (meet == V) return false;
+    if (path) {
+        for (auto v = meet; v != source; v = workspace.index.get(v) - 1)
+            path->push_back(v);
+        path->push_back(source);
+        std::reverse(path->begin(), path->end());
+        for (auto v = meet; v != sink;) {
+            v = workspace.low.get(v) - 1;
+            path->push_back(v);
+        }
+    }
+    return true;
+}
+}  // namespace
+
+bool DirectedGraph::bidirectional_search(Workspace& workspace, size_t source,
+                                         size_t sink,
+                                         std::vector<size_t>* path) const {
+    assert(source < VN_ && sink < VN_);
+    if (fits_csr32())
+        return graph_sdk::bidirectional_search(*cached_csr(),
+                                               *cached_reverse_csr(),
+                                               workspace, source, sink, path);
+    return graph_sdk::bidirectional_search(*cached_wide_csr(),
+                                           *cached_wide_reverse_csr(),
+                                           workspace, source, sink, path);
+}
+
+bool DirectedGraph::is_reachable(Workspace& workspace, size_t source,
+                                 size_t sink) const {
+    return bidirectional_search(workspace, source, sink, nullptr);
+}
+
+bool DirectedGraph::shortest_path(Workspace& workspace, size_t source,
+                                  size_t sink,
+                                  std::vector<size_t>& path) const {
+    return bidirectional_search(workspace, source, sink, &path);
+}
+
+// iterative variants on a reusable workspace, same visiting order as the
+// recursive helpers above
+void DirectedGraph::dfs(Workspace& workspace,
+                        std::vector<size_t>& dfs_nodes) const {
+    workspace.reset(VN_);
+    dfs_nodes.clear();
+    auto& frames = workspace.frames;
+    for (size_t i = 0; i < VN_; ++i) {
+        if (workspace.state.get(i)) continue;
+        workspace.state.set(i, 1);
+        dfs_nodes.push_back(i);
+        frames.emplace_back(i, adjacency_[i].begin());
+        while (!frames.empty()) {
+            auto& [curr, it] = frames.back();
+            if (it == adjacency_[curr].end()) {
+                GRAPH_SDK_COUNT_EDGES(adjacency_[curr].size());
+                frames.pop_back();
+                continue;
+            }
+            auto x = *it++;
+            if (workspace.state.get(x)) continue;
+            workspace.state.set(x, 1);
+            dfs_nodes.push_back(x);
+            frames.emplace_back(x, adjacency_[x].begin());
+        }
+    }
+    GRAPH_SDK_COUNT_VERTICES(dfs_nodes.size());
+}
+
+bool DirectedGraph::topological_sort(Workspace& workspace,
+                                     std::vector<size_t>& order) const {
+    // 1 for visiting, 2 for done-visited; order is the reversed post order
+    workspace.reset(VN_);
+    order.clear();
+    auto& frames = workspace.frames;
+    for (size_t i = 0; i < VN_; ++i) {
+        if (workspace.state.get(i)) continue;
+        workspace.state.set(i, 1);
+        frames.emplace_back(i, adjacency_[i].begin());
+        while (!frames.empty()) {
+            auto& [curr, it] = frames.back();
+            if (it == adjacency_[curr].end()) {
+                workspace.state.set(curr, 2);
+                order.push_back(curr);
+                frames.pop_back();
+                continue;
+            }
+            auto x = *it++;
+            if (auto state = workspace.state.get(x); state == 1) {
+                order.clear();
+                return false;
+            } else if (state == 0) {
+                workspace.state.set(x, 1);
+                frames.emplace_back(x, adjacency_[x].begin());
+            }
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return true;
+}
+
+bool DirectedGraph::has_cycle(Workspace& workspace) const {
+    workspace.reset(VN_);
+    auto& frames = workspace.frames;
+    for (size_t i = 0; i < VN_; ++i) {
+        if (workspace.state.get(i)) continue;
+        workspace.state.set(i, 1);
+        frames.emplace_back(i, adjacency_[i].begin());
+        while (!frames.empty()) {
+            auto& [curr, it] = frames.back();
+            if (it == adjacency_[curr].end()) {
+                workspace.state.set(curr, 2);
+                frames.pop_back();
+                continue;
+            }
+            auto x = *it++;
+            if (auto state = workspace.state.get(x); state == 1) {
+                return true;
+            } else if (state == 0) {
+                workspace.state.set(x, 1);
+                frames.emplace_back(x, adjacency_[x].begin());
+            }
+        }
+    }
+    return false;
+}
+
+bool DirectedGraph::extract_scc(Workspace& workspace,
+                                std::vector<size_t>& scc) const {
+    workspace.reset(VN_);
+    scc.assign(VN_, VN_);
+    auto& frames = workspace.frames;
+    auto& visiting = workspace.stack;
+    size_t counter = 0;
+    bool cyclic = false;
+
+    auto enter = [&](size_t x) {
+        workspace.index.set(x, ++counter);
+        workspace.low.set(x, counter);
+        visiting.push_back(x);
+        frames.emplace_back(x, adjacency_[x].begin());
+    };
+    for (size_t i = 0; i < VN_; ++i) {
+        if (workspace.index.get(i)) continue;
+        enter(i);
+        while (!frames.empty()) {
+            auto& [curr, it] = frames.back();
+            if (it != adjacency_[curr].end()) {
+                auto x = *it++;
+                if (x == curr) cyclic = true;
+                if (workspace.index.get(x) == 0) {
+                    enter(x);
+                } else if (scc[x] == VN_) {
+                    workspace.low.set(curr, std::min(workspace.low.get(curr),
+                                                     workspace.index.get(x)));
+                }
+                continue;
+            }
+            auto v = curr;
+            frames.pop_back();
+            if (!frames.empty()) {
+                auto parent = frames.back().first;
+                workspace.low.set(parent, std::min(workspace.low.get(parent),
+                                                   workspace.low.get(v)));
+            }
+            if (workspace.low.get(v) != workspace.index.get(v)) continue;
+            auto first =
+                std::find(visiting.rbegin(), visiting.rend(), v).base() - 1;
+            if (visiting.end() - first > 1) cyclic = true;
+            auto label = *std::min_element(first, visiting.end());
+            std::for_each(first, visiting.end(),
+                          [&](const auto& x) { scc[x] = label; });
+            visiting.erase(first, visiting.end());
+        }
+    }
+    return cyclic;
+}
+
 
 // for visilization and debug
 void DirectedGraph::print_graph() const {
@@ -514,13 +1051,12 @@ void DirectedGraph::print_graph() const {
 }
 
 void DirectedGraph::print_matrix() const {
-    // TODO: if calculated already?
-    auto matrix = DirectedGraph::extract_matrix();
+    auto matrix = DirectedGraph::cached_matrix();
     // TODO: better visualization
     std::cout << "=========== print graph matrix ==========" << std::endl;
     // std::for_each(matrix.begin(), matrix.end(),
     //[](const auto& x){print_elem(x);});
-    matrix.print();
+    matrix->print();
 }
 
 /*
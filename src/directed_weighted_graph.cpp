@@ -1,6 +1,9 @@
+#include <atomic>
 #include <limits>
+#include <memory>
 
 #include "../include/graph.h"
+#include "../include/instrument.h"
 
 namespace graph_sdk {
 DiWeightedGraph::DiWeightedGraph(const WeightedEdges& edges) {
@@ -9,7 +12,7 @@ DiWeightedGraph::DiWeightedGraph(const WeightedEdges& edges) {
 
     weighted_edges_ = edges;
     for (const auto& [key, value] : weighted_edges_) {
-        auto size = std::max(key.first, key.second);
+        auto size = std::max(key.first, key.second) + 1;
         if (size > adjacency_.size()) {
             adjacency_.resize(size);
         }
@@ -22,9 +25,10 @@ DiWeightedGraph::DiWeightedGraph(const WeightedEdges& edges) {
 
 bool DiWeightedGraph::add_edge(std::tuple<size_t, size_t, int> weighted_edge) {
     auto [p0, p1, v] = weighted_edge;
+    ++version_;
     if (auto max_tmp = std::max(p0, p1); max_tmp >= adjacency_.size()) {
         adjacency_.resize(max_tmp + 1);
-        VN_ += 1;
+        VN_ = adjacency_.size();
     }
     auto tmp1 = adjacency_[p0].insert(p1);
     if (tmp1.second) {
@@ -37,6 +41,7 @@ bool DiWeightedGraph::add_edge(std::tuple<size_t, size_t, int> weighted_edge) {
 bool DiWeightedGraph::remove_node(size_t idx) {
     auto N = VN_;
     if (idx >= N) return false;
+    ++version_;
 
     for (auto i = 0; i < N; ++i) {
         if (idx == i) {
@@ -64,6 +69,7 @@ bool DiWeightedGraph::remove_node(size_t idx) {
 }
 bool DiWeightedGraph::remove_edge(std::pair<size_t, size_t> arrow) {
     if (arrow.first >= adjacency_.size()) return false;
+    ++version_;
     if (auto it = adjacency_[arrow.first].find(arrow.second);
         it != adjacency_[arrow.first].end()) {
         adjacency_[arrow.first].erase(it);
@@ -84,9 +90,9 @@ bool DiWeightedGraph::is_positive_weighted() const {
 bool DiWeightedGraph::update_flow_graph(
     size_t source, size_t sink,
     std::vector<std::unordered_map<size_t, int>>& flow_adjacency,
-    int& flow_value) const {
+    int& flow_value, const ExecutionPolicy& policy) const {
     std::vector<size_t> path{};
-    find_one_path_helper(source, sink, flow_adjacency, path);
+    find_one_path_helper(source, sink, flow_adjacency, path, policy);
     if (path.empty()) return false;
 
     int min_value = std::numeric_limits<int>::max();
@@ -114,16 +120,63 @@ bool DiWeightedGraph::update_flow_graph(
     return true;
 }
 
+// shortest augmenting path by level synchronous bfs. A node reached from
+// several frontier nodes takes the first of them as parent, so the path
+// does not depend on how the frontier was split between threads.
 void DiWeightedGraph::find_one_path_helper(
     size_t source, size_t sink,
     const std::vector<std::unordered_map<size_t, int>>& flow_adjacency,
-    std::vector<size_t>& path) const {
-    path.push_back(source);
-    if (source == sink) return;
-    for (const auto& [id, value] : flow_adjacency[source]) {
-        find_one_path_helper(id, sink, flow_adjacency, path);
+    std::vector<size_t>& path, const ExecutionPolicy& policy) const {
+    constexpr size_t none = std::numeric_limits<size_t>::max();
+    const auto N = flow_adjacency.size();
+    std::vector<size_t> parent(N, none);
+    std::unique_ptr<std::atomic<size_t>[]> claim(new std::atomic<size_t>[N]);
+    for (size_t i = 0; i < N; ++i) claim[i].store(none);
+
+    std::vector<size_t> frontier{source};
+    parent[source] = source;
+    while (!frontier.empty() && parent[sink] == none) {
+        const size_t grain = 256;
+        auto propose = [&](size_t b, size_t e) {
+            GRAPH_SDK_COUNT_VERTICES(e - b);
+            for (size_t f = b; f < e; ++f) {
+                GRAPH_SDK_COUNT_EDGES(flow_adjacency[frontier[f]].size());
+                for (const auto& [id, value] : flow_adjacency[frontier[f]]) {
+                    if (parent[id] != none) continue;
+                    auto curr = claim[id].load(std::memory_order_relaxed);
+                    while (f < curr &&
+                           !claim[id].compare_exchange_weak(curr, f)) {
+                    }
+                }
+            }
+        };
+        parallel_for(policy, 0, frontier.size(), grain, propose);
+        const size_t chunks = (frontier.size() + grain - 1) / grain;
+        std::vector<std::vector<size_t>> next(chunks);
+        auto collect = [&](size_t b, size_t e) {
+            auto& out = next[b / grain];
+            for (size_t f = b; f < e; ++f) {
+                for (const auto& [id, value] : flow_adjacency[frontier[f]]) {
+                    if (parent[id] == none && claim[id].load() == f)
+                        out.push_back(id);
+                }
+            }
+        };
+        parallel_for(policy, 0, frontier.size(), grain, collect);
+        std::vector<size_t> reached{};
+        for (auto& chunk : next) {
+            for (auto x : chunk) {
+                parent[x] = frontier[claim[x].load()];
+                reached.push_back(x);
+            }
+        }
+        frontier = std::move(reached);
     }
-    path.pop_back();
+    if (parent[sink] == none) return;
+    for (auto curr = sink; curr != source; curr = parent[curr])
+        path.push_back(curr);
+    path.push_back(source);
+    std::reverse(path.begin(), path.end());
 }
 
 std::vector<std::unordered_map<size_t, int>>
@@ -140,17 +193,60 @@ DiWeightedGraph::get_weighted_adjacency() const {
     return weighted_adjacency;
 }
 
-int DiWeightedGraph::max_flow(size_t source, size_t sink) const {
-    int flow_value = 0;
+void DiWeightedGraph::relabel(const std::vector<size_t>& inverse) {
+    DirectedGraph::relabel(inverse);
+    WeightedEdges weighted_edges{};
+    weighted_edges.reserve(weighted_edges_.size());
+    for (const auto& [key, value] : weighted_edges_) {
+        weighted_edges.insert(
+            {std::make_pair(inverse[key.first], inverse[key.second]), value});
+    }
+    weighted_edges_ = std::move(weighted_edges);
+}
+
+std::pair<std::vector<size_t>, std::vector<size_t>> DiWeightedGraph::reorder(
+    Ordering ordering) {
+    auto permutation = DirectedGraph::compute_ordering(ordering);
+    std::vector<size_t> inverse(permutation.size());
+    for (size_t i = 0; i < permutation.size(); ++i) inverse[permutation[i]] = i;
+    DiWeightedGraph::relabel(inverse);
+    return std::make_pair(permutation, inverse);
+}
+
+int DiWeightedGraph::max_flow(size_t source, size_t sink,
+                              const ExecutionPolicy& policy) const {
+    GRAPH_SDK_RECORD("max_flow");
+    std::vector<BipartiteSide> side{};
+    if (CsrGraph32::fits(VN_, EN_) &&
+        DiWeightedGraph::unit_bipartite(source, sink, side)) {
+        GRAPH_SDK_PHASE("hopcroft_karp");
+        std::vector<uint32_t> mate{};
+        auto matched = hopcroft_karp(DirectedGraph::to_csr(), side, mate);
+        return int(matched + adjacency_[source].count(sink));
+    }
+
     std::vector<std::unordered_map<size_t, int>> flow_adjacency =
         DiWeightedGraph::get_weighted_adjacency();
+    return DiWeightedGraph::saturate(source, sink, flow_adjacency, policy);
+}
 
+// augments until no path is left, flow_adjacency ends as the residual graph
+int DiWeightedGraph::saturate(
+    size_t source, size_t sink,
+    std::vector<std::unordered_map<size_t, int>>& flow_adjacency,
+    const ExecutionPolicy& policy) const {
+    GRAPH_SDK_PHASE("augment");
+    int flow_value = 0;
     bool update = true;
     while (update) {
-        update = DiWeightedGraph::update_flow_graph(source, sink,
-                                                    flow_adjacency, flow_value);
+        update = DiWeightedGraph::update_flow_graph(
+            source, sink, flow_adjacency, flow_value, policy);
     }
     return flow_value;
 }
 
+const WeightedEdges& DiWeightedGraph::extract_weighted_edges() const {
+    return weighted_edges_;
+}
+
 }  // namespace graph_sdk
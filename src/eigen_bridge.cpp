@@ -0,0 +1,151 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <Eigen/SparseCholesky>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+#include "../include/eigen_bridge.h"
+#include "../include/instrument.h"
+
+namespace graph_sdk {
+
+namespace {
+// the int32_t indices of Eigen hold less than CsrGraph<>, fail rather than
+// wrap around
+void check_index(size_t V, size_t nonzeros) {
+    if (!CsrGraph<int32_t, int32_t>::fits(V, nonzeros))
+        throw std::length_error("graph exceeds the Eigen index type");
+}
+
+template <class Matrix, class Csr>
+Matrix compressed_copy(const Csr& csr) {
+    check_index(csr.node_num(), csr.edge_num());
+    const auto V = Eigen::Index(csr.node_num());
+    Matrix m(V, V);
+    m.resizeNonZeros(Eigen::Index(csr.edge_num()));
+    std::copy(csr.offsets().begin(), csr.offsets().end(), m.outerIndexPtr());
+    std::copy(csr.targets().begin(), csr.targets().end(), m.innerIndexPtr());
+    std::fill_n(m.valuePtr(), csr.edge_num(), 1.0);
+    return m;
+}
+
+// columns of x orthonormal, x keeps its shape
+void orthonormalize(Eigen::MatrixXd& x) {
+    Eigen::HouseholderQR<Eigen::MatrixXd> qr(x);
+    x = qr.householderQ() * Eigen::MatrixXd::Identity(x.rows(), x.cols());
+}
+}  // namespace
+
+EigenAdjacency::EigenAdjacency(const DirectedGraph& graph)
+    : csr_(graph.to_csr<int32_t, int32_t>()),
+      values_(csr_.edge_num(), 1.0) {}
+
+EigenAdjacency::EigenAdjacency(const DiWeightedGraph& graph)
+    : csr_(graph.to_csr<int32_t, int32_t>()), values_(csr_.edge_num()) {
+    const auto& weighted = graph.extract_weighted_edges();
+    for (size_t i = 0; i < csr_.node_num(); ++i) {
+        for (auto e = csr_.offsets()[i]; e < csr_.offsets()[i + 1]; ++e)
+            values_[e] = weighted.at({i, size_t(csr_.targets()[e])});
+    }
+}
+
+EigenCsr to_eigen(const DirectedGraph& graph) {
+    return compressed_copy<EigenCsr>(*graph.cached_csr());
+}
+
+EigenCsr to_eigen(const DiWeightedGraph& graph) {
+    auto csr = graph.cached_csr();
+    auto m = compressed_copy<EigenCsr>(*csr);
+    const auto& weighted = graph.extract_weighted_edges();
+    for (size_t i = 0; i < csr->node_num(); ++i) {
+        for (auto e = csr->offsets()[i]; e < csr->offsets()[i + 1]; ++e)
+            m.valuePtr()[e] = weighted.at({i, size_t(csr->targets()[e])});
+    }
+    return m;
+}
+
+EigenCsc to_eigen_csc(const DirectedGraph& graph) {
+    return compressed_copy<EigenCsc>(graph.cached_csr()->reverse());
+}
+
+EigenCsc eigen_laplacian(const DirectedGraph& graph) {
+    const auto undirected = symmetrize(*graph.cached_csr());
+    const auto V = undirected.node_num();
+    check_index(V, undirected.edge_num() + V);
+    EigenCsc L{Eigen::Index(V), Eigen::Index(V)};
+    L.resizeNonZeros(Eigen::Index(undirected.edge_num() + V));
+    auto* outer = L.outerIndexPtr();
+    auto* inner = L.innerIndexPtr();
+    auto* values = L.valuePtr();
+    int32_t k = 0;
+    outer[0] = 0;
+    for (size_t v = 0; v < V; ++v) {
+        auto row = undirected.neighbours(v);
+        auto split = std::lower_bound(row.begin(), row.end(), uint32_t(v));
+        for (auto it = row.begin(); it != split; ++it, ++k) {
+            inner[k] = int32_t(*it);
+            values[k] = -1.0;
+        }
+        inner[k] = int32_t(v);
+        values[k++] = double(row.size());
+        for (auto it = split; it != row.end(); ++it, ++k) {
+            inner[k] = int32_t(*it);
+            values[k] = -1.0;
+        }
+        outer[v + 1] = k;
+    }
+    return L;
+}
+
+// Subspace iteration on (L + shift I)^-1 converges to the eigenvectors of
+// the smallest eigenvalues; a Rayleigh-Ritz step on L orders them. The
+// block carries a few spare vectors, which speeds up the wanted ones.
+std::pair<bool, Eigen::MatrixXd> eigen_spectral_embedding(
+    const DirectedGraph& graph, size_t dimensions) {
+    GRAPH_SDK_RECORD("eigen_spectral_embedding");
+    const auto L = eigen_laplacian(graph);
+    const auto V = size_t(L.rows());
+    const auto wanted = std::min(dimensions + 1, V);
+    if (wanted <= 1) return std::make_pair(true, Eigen::MatrixXd(V, 0));
+    const auto block = std::min(wanted + 4, V);
+    const double shift = 1e-3, tolerance = 1e-10;
+    const size_t max_iterations = 500;
+
+    EigenCsc identity(L.rows(), L.cols());
+    identity.setIdentity();
+    Eigen::SimplicialLDLT<EigenCsc> solver(L + shift * identity);
+    if (solver.info() != Eigen::Success)
+        return std::make_pair(false, Eigen::MatrixXd{});
+
+    std::mt19937 rng(V);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    Eigen::MatrixXd x(V, block);
+    for (Eigen::Index j = 0; j < x.cols(); ++j) {
+        for (Eigen::Index i = 0; i < x.rows(); ++i) x(i, j) = uniform(rng);
+    }
+    orthonormalize(x);
+    Eigen::VectorXd previous = Eigen::VectorXd::Constant(block, -1.0);
+    for (size_t iteration = 0; iteration < max_iterations; ++iteration) {
+        x = solver.solve(x);
+        orthonormalize(x);
+        Eigen::MatrixXd h = x.transpose() * (L * x);
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> ritz(h);
+        x = x * ritz.eigenvectors();
+        const auto& lambda = ritz.eigenvalues();
+        bool converged = true;
+        for (size_t k = 0; k < wanted; ++k) {
+            if (std::abs(lambda[k] - previous[k]) >
+                tolerance * (1.0 + std::abs(lambda[k])))
+                converged = false;
+        }
+        previous = lambda;
+        if (converged) {
+            Eigen::MatrixXd coordinates = x.middleCols(1, wanted - 1);
+            return std::make_pair(true, coordinates);
+        }
+    }
+    return std::make_pair(false, Eigen::MatrixXd{});
+}
+}  // namespace graph_sdk
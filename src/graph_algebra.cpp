@@ -0,0 +1,156 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "../include/graph_algebra.h"
+#include "../include/instrument.h"
+#include "../include/semiring.h"
+#include "../include/sparse_matrix.h"
+
+namespace graph_sdk {
+
+// direction switch of Beamer et al.: pull once the frontier's out-edges
+// exceed 1/14 of all edges
+std::vector<size_t> algebraic_bfs(const DirectedGraph& graph, size_t source,
+                                  const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("algebraic_bfs");
+    using S = BooleanSemiring;
+    constexpr auto unreached = std::numeric_limits<size_t>::max();
+    auto A = SparseMatrix<uint8_t>::pattern(graph);
+    const auto V = A.rows();
+    std::vector<size_t> level(V, unreached);
+    if (source >= V) return level;
+
+    SparseMatrix<uint8_t> AT{};
+    std::vector<uint8_t> visited(V, 0), dense{}, next{};
+    const Mask unvisited{&visited, true};
+    SparseVector<uint8_t> frontier{{source}, {1}};
+    visited[source] = 1;
+    level[source] = 0;
+    for (size_t depth = 1; frontier.nnz() > 0; ++depth) {
+        size_t work = 0;
+        for (auto v : frontier.indices) work += A.row_nnz(v);
+        if (work * 14 > A.nnz()) {
+            GRAPH_SDK_PHASE("pull");
+            if (AT.rows() != V) AT = A.transpose();
+            dense.assign(V, 0);
+            next.assign(V, 0);
+            for (auto v : frontier.indices) dense[v] = 1;
+            mxv<S>(AT, dense, next, unvisited, policy);
+            frontier = SparseVector<uint8_t>{};
+            for (size_t i = 0; i < V; ++i) {
+                if (!next[i]) continue;
+                frontier.indices.push_back(i);
+                frontier.values.push_back(1);
+            }
+        } else {
+            GRAPH_SDK_PHASE("push");
+            frontier = vxm<S>(frontier, A, unvisited, policy);
+        }
+        for (auto v : frontier.indices) {
+            visited[v] = 1;
+            level[v] = depth;
+        }
+        GRAPH_SDK_COUNT_EDGES(work);
+    }
+    return level;
+}
+
+// every round relaxes the out-edges of the nodes improved in the previous
+// one; an improvement in round V means a negative cycle
+std::pair<bool, std::vector<int64_t>> algebraic_sssp(
+    const DiWeightedGraph& graph, size_t source,
+    const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("algebraic_sssp");
+    using S = MinPlusSemiring<int64_t>;
+    auto A = SparseMatrix<int64_t>::weights(graph);
+    const auto V = A.rows();
+    std::vector<int64_t> distance(V, S::zero());
+    if (source >= V) return std::make_pair(true, distance);
+
+    distance[source] = 0;
+    SparseVector<int64_t> frontier{{source}, {0}};
+    for (size_t round = 0; frontier.nnz() > 0; ++round) {
+        if (round == V) return std::make_pair(false, distance);
+        auto relaxed = vxm<S>(frontier, A, {}, policy);
+        SparseVector<int64_t> next{};
+        for (size_t k = 0; k < relaxed.nnz(); ++k) {
+            auto j = relaxed.indices[k];
+            if (relaxed.values[k] >= distance[j]) continue;
+            distance[j] = relaxed.values[k];
+            next.indices.push_back(j);
+            next.values.push_back(distance[j]);
+        }
+        frontier = std::move(next);
+    }
+    return std::make_pair(true, distance);
+}
+
+uint64_t algebraic_triangle_count(const DirectedGraph& graph,
+                                  const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("algebraic_triangle_count");
+    using S = PlusTimesSemiring<uint64_t>;
+    auto csr = graph.to_csr<uint32_t, size_t>();
+    const auto V = csr.node_num();
+    // strictly lower triangle of the symmetrized pattern
+    std::vector<std::pair<uint32_t, uint32_t>> lower{};
+    lower.reserve(csr.edge_num());
+    for (size_t u = 0; u < V; ++u) {
+        for (auto v : csr.neighbours(u)) {
+            if (u != v)
+                lower.emplace_back(std::max<uint32_t>(u, v),
+                                   std::min<uint32_t>(u, v));
+        }
+    }
+    std::sort(lower.begin(), lower.end());
+    lower.erase(std::unique(lower.begin(), lower.end()), lower.end());
+    std::vector<size_t> offsets(V + 1, 0);
+    std::vector<uint32_t> indices(lower.size());
+    for (size_t k = 0; k < lower.size(); ++k) {
+        offsets[lower[k].first + 1] += 1;
+        indices[k] = lower[k].second;
+    }
+    for (size_t i = 0; i < V; ++i) offsets[i + 1] += offsets[i];
+    SparseMatrix<uint64_t> L(V, V, std::move(offsets), std::move(indices),
+                             std::vector<uint64_t>(lower.size(), 1));
+
+    auto C = mxm<S>(L, L, &L, policy);
+    return reduce<S>(C);
+}
+
+std::vector<double> algebraic_pagerank(const DirectedGraph& graph,
+                                       double damping, double tolerance,
+                                       size_t max_iterations,
+                                       const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("algebraic_pagerank");
+    using S = PlusTimesSemiring<double>;
+    auto A = SparseMatrix<double>::pattern(graph);
+    const auto V = A.rows();
+    if (V == 0) return {};
+    auto P = A.apply([&](size_t i, size_t, double) {
+                  return 1.0 / double(A.row_nnz(i));
+              }).transpose();
+    std::vector<size_t> sinks{};
+    for (size_t i = 0; i < V; ++i) {
+        if (A.row_nnz(i) == 0) sinks.push_back(i);
+    }
+
+    std::vector<double> rank(V, 1.0 / double(V)), next(V, 0.0);
+    for (size_t iteration = 0; iteration < max_iterations; ++iteration) {
+        double dangling = 0.0;
+        for (auto x : sinks) dangling += rank[x];
+        mxv<S>(P, rank, next, {}, policy);
+        const double base = (1.0 - damping + damping * dangling) / double(V);
+        double change = 0.0;
+        for (size_t i = 0; i < V; ++i) {
+            auto value = base + damping * next[i];
+            change += std::abs(value - rank[i]);
+            rank[i] = value;
+        }
+        if (change < tolerance) break;
+    }
+    return rank;
+}
+}  // namespace graph_sdk
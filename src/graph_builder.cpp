@@ -0,0 +1,84 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+#include "../include/graph_builder.h"
+#include "../include/instrument.h"
+
+namespace graph_sdk {
+
+namespace {
+// segment s holds the nodes [first * (2^s - 1), first * (2^(s+1) - 1))
+size_t segment_of(size_t v, size_t first) {
+    return 63 - __builtin_clzll(v / first + 1);
+}
+
+size_t segment_begin(size_t s, size_t first) {
+    return first * ((size_t{1} << s) - 1);
+}
+}  // namespace
+
+ConcurrentGraphBuilder::~ConcurrentGraphBuilder() {
+    for (auto& segment : segments_) delete[] segment.load();
+}
+
+std::vector<size_t>& ConcurrentGraphBuilder::row(size_t v) {
+    auto s = segment_of(v, first_segment);
+    assert(s < segment_num);
+    auto* segment = segments_[s].load(std::memory_order_acquire);
+    if (segment == nullptr) {
+        auto* fresh = new std::vector<size_t>[first_segment << s];
+        if (segments_[s].compare_exchange_strong(segment, fresh,
+                                                 std::memory_order_acq_rel))
+            segment = fresh;
+        else
+            delete[] fresh;
+    }
+    return segment[v - segment_begin(s, first_segment)];
+}
+
+void ConcurrentGraphBuilder::add_edge(std::pair<size_t, size_t> arrow) {
+    auto size = std::max(arrow.first, arrow.second) + 1;
+    auto known = node_num_.load(std::memory_order_relaxed);
+    while (known < size && !node_num_.compare_exchange_weak(known, size)) {
+    }
+
+    auto& target = row(arrow.first);
+    {
+        std::lock_guard<std::mutex> lock(
+            stripes_[arrow.first % stripe_num].mutex);
+        target.push_back(arrow.second);
+    }
+    thread_local const size_t shard =
+        std::hash<std::thread::id>{}(std::this_thread::get_id()) % shard_num;
+    shards_[shard].count.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t ConcurrentGraphBuilder::event_num() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shard_num; ++i)
+        total += shards_[i].count.load(std::memory_order_relaxed);
+    return total;
+}
+
+DirectedGraph ConcurrentGraphBuilder::build(const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("concurrent_graph_build");
+    const auto V = node_num_.load();
+    Adjacency adjacency(V);
+    parallel_for(policy, 0, V, 1024, [&](size_t b, size_t e) {
+        for (size_t v = b; v < e; ++v) {
+            auto s = segment_of(v, first_segment);
+            auto* segment = segments_[s].load();
+            if (segment == nullptr) continue;
+            auto& x = segment[v - segment_begin(s, first_segment)];
+            std::sort(x.begin(), x.end());
+            x.erase(std::unique(x.begin(), x.end()), x.end());
+            for (auto y : x) adjacency[v].insert(adjacency[v].end(), y);
+            GRAPH_SDK_COUNT_EDGES(x.size());
+        }
+    });
+    return DirectedGraph(adjacency);
+}
+}  // namespace graph_sdk
@@ -0,0 +1,474 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string_view>
+
+#include "../include/csr.h"
+#include "../include/graph_io.h"
+#include "../include/instrument.h"
+
+namespace graph_sdk {
+
+namespace {
+constexpr size_t block_edges = size_t{1} << 16;
+constexpr size_t block_rows = size_t{1} << 16;
+constexpr size_t read_buffer = size_t{1} << 20;
+
+using Emit = std::function<bool(const std::string&)>;
+
+template <typename T>
+void append_number(std::string& out, T x) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), x);
+    out.append(digits, result.ptr);
+}
+
+std::string header(GraphFormat format, size_t V, bool weighted) {
+    switch (format) {
+        case GraphFormat::dot:
+            return "digraph G {\n";
+        case GraphFormat::graphml: {
+            std::string out =
+                "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n";
+            if (weighted)
+                out += "  <key id=\"weight\" for=\"edge\" "
+                       "attr.name=\"weight\" attr.type=\"int\"/>\n";
+            return out + "  <graph id=\"G\" edgedefault=\"directed\">\n";
+        }
+        case GraphFormat::json: {
+            std::string out = "{\"directed\":true,\"nodes\":";
+            append_number(out, V);
+            return out + ",\"edges\":[\n";
+        }
+    }
+    return {};
+}
+
+std::string footer(GraphFormat format) {
+    switch (format) {
+        case GraphFormat::dot:
+            return "}\n";
+        case GraphFormat::graphml:
+            return "  </graph>\n</graphml>\n";
+        case GraphFormat::json:
+            return "\n]}\n";
+    }
+    return {};
+}
+
+// weights, when given, belong to csr.targets()
+template <class Graph>
+void format_rows(const Graph& csr, const std::vector<int>* weights,
+                 GraphFormat format, size_t b, size_t e, std::string& out) {
+    for (size_t v = b; v < e; ++v) {
+        const auto first = csr.offsets()[v], last = csr.offsets()[v + 1];
+        if (format == GraphFormat::dot && first == last) {
+            out += "  ";
+            append_number(out, v);
+            out += ";\n";
+        }
+        if (format == GraphFormat::graphml) {
+            out += "    <node id=\"n";
+            append_number(out, v);
+            out += "\"/>\n";
+        }
+        for (auto k = first; k < last; ++k) {
+            auto w = csr.targets()[k];
+            switch (format) {
+                case GraphFormat::dot:
+                    out += "  ";
+                    append_number(out, v);
+                    out += " -> ";
+                    append_number(out, w);
+                    if (weights) {
+                        out += " [weight=";
+                        append_number(out, (*weights)[k]);
+                        out += "]";
+                    }
+                    out += ";\n";
+                    break;
+                case GraphFormat::graphml:
+                    out += "    <edge source=\"n";
+                    append_number(out, v);
+                    out += "\" target=\"n";
+                    append_number(out, w);
+                    if (weights) {
+                        out += "\"><data key=\"weight\">";
+                        append_number(out, (*weights)[k]);
+                        out += "</data></edge>\n";
+                    } else {
+                        out += "\"/>\n";
+                    }
+                    break;
+                case GraphFormat::json:
+                    if (k != 0) out += ",\n";
+                    out += "[";
+                    append_number(out, v);
+                    out += ",";
+                    append_number(out, w);
+                    if (weights) {
+                        out += ",";
+                        append_number(out, (*weights)[k]);
+                    }
+                    out += "]";
+                    break;
+            }
+        }
+    }
+}
+
+template <class Graph>
+bool write_blocks(const Graph& csr, const std::vector<int>* weights,
+                  GraphFormat format, const ExecutionPolicy& policy,
+                  const Emit& emit) {
+    const auto V = csr.node_num();
+    std::vector<size_t> bounds{0};
+    for (size_t v = 0, edges = 0; v < V; ++v) {
+        edges += csr.degree(v);
+        if (edges >= block_edges || v + 1 - bounds.back() >= block_rows) {
+            bounds.push_back(v + 1);
+            edges = 0;
+        }
+    }
+    if (bounds.back() != V) bounds.push_back(V);
+
+    if (!emit(header(format, V, weights != nullptr))) return false;
+    // a round bounds the memory held by formatted blocks
+    const size_t round = 4 * policy.threads();
+    std::vector<std::string> buffers(round);
+    for (size_t first = 0; first + 1 < bounds.size(); first += round) {
+        const auto count = std::min(round, bounds.size() - 1 - first);
+        parallel_for(policy, 0, count, 1, [&](size_t b, size_t e) {
+            for (auto i = b; i < e; ++i) {
+                buffers[i].clear();
+                format_rows(csr, weights, format, bounds[first + i],
+                            bounds[first + i + 1], buffers[i]);
+            }
+        });
+        for (size_t i = 0; i < count; ++i) {
+            if (!emit(buffers[i])) return false;
+        }
+    }
+    return emit(footer(format));
+}
+
+template <class Graph>
+std::vector<int> csr_weights(const DiWeightedGraph& graph,
+                             const Graph& csr) {
+    const auto& weighted = graph.extract_weighted_edges();
+    std::vector<int> weights(csr.edge_num());
+    for (size_t v = 0; v < csr.node_num(); ++v) {
+        for (auto k = csr.offsets()[v]; k < csr.offsets()[v + 1]; ++k)
+            weights[k] = weighted.at({v, size_t(csr.targets()[k])});
+    }
+    return weights;
+}
+
+template <class Graph>
+bool write_stream(std::ostream& out, const Graph& csr,
+                  const std::vector<int>* weights, GraphFormat format,
+                  const ExecutionPolicy& policy) {
+    return write_blocks(csr, weights, format, policy,
+                        [&](const std::string& text) {
+                            out.write(text.data(),
+                                      std::streamsize(text.size()));
+                            return bool(out);
+                        });
+}
+
+template <class Graph>
+bool write_file(const std::string& path, const Graph& csr,
+                const std::vector<int>* weights, GraphFormat format,
+                const ExecutionPolicy& policy) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+    return write_stream(out, csr, weights, format, policy) &&
+           bool(out.flush());
+}
+
+template <class Graph>
+size_t write_chunks(const std::string& path, const Graph& csr,
+                    const std::vector<int>* weights, GraphFormat format,
+                    size_t chunk_bytes, const ExecutionPolicy& policy) {
+    std::ofstream part{};
+    size_t parts = 0, written = 0;
+    auto ok = write_blocks(
+        csr, weights, format, policy, [&](const std::string& text) {
+            if (!part.is_open() || written >= chunk_bytes) {
+                if (part.is_open() && !part.flush()) return false;
+                part = std::ofstream(path + "." + std::to_string(parts++),
+                                     std::ios::binary);
+                written = 0;
+            }
+            part.write(text.data(), std::streamsize(text.size()));
+            written += text.size();
+            return bool(part);
+        });
+    return ok && part.flush() ? parts : 0;
+}
+
+// Lines of a stream read through one large buffer.
+class LineReader {
+   private:
+    std::istream& in_;
+    std::vector<char> buffer_;
+    size_t begin_{0};
+    size_t end_{0};
+    std::string line_{};
+
+   public:
+    explicit LineReader(std::istream& in) : in_(in), buffer_(read_buffer) {}
+
+    bool next(std::string_view& line) {
+        line_.clear();
+        for (;;) {
+            if (begin_ == end_) {
+                in_.read(buffer_.data(), std::streamsize(buffer_.size()));
+                end_ = size_t(in_.gcount());
+                begin_ = 0;
+                if (end_ == 0) {
+                    line = line_;
+                    return !line_.empty();
+                }
+            }
+            auto* start = buffer_.data() + begin_;
+            auto* newline =
+                static_cast<char*>(std::memchr(start, '\n', end_ - begin_));
+            if (newline != nullptr) {
+                line_.append(start, newline);
+                begin_ = newline - buffer_.data() + 1;
+                line = line_;
+                return true;
+            }
+            line_.append(start, buffer_.data() + end_);
+            begin_ = end_;
+        }
+    }
+};
+
+void skip_spaces(std::string_view& s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' ||
+                          s.front() == '\r'))
+        s.remove_prefix(1);
+}
+
+template <typename T>
+bool parse_number(std::string_view& s, T& x) {
+    skip_spaces(s);
+    auto result = std::from_chars(s.data(), s.data() + s.size(), x);
+    if (result.ec != std::errc()) return false;
+    s.remove_prefix(result.ptr - s.data());
+    return true;
+}
+
+bool consume(std::string_view& s, std::string_view token) {
+    skip_spaces(s);
+    if (s.substr(0, token.size()) != token) return false;
+    s.remove_prefix(token.size());
+    return true;
+}
+
+// the number after `key`, an `n` prefix allowed
+bool parse_attribute(std::string_view s, std::string_view key, size_t& x) {
+    auto at = s.find(key);
+    if (at == std::string_view::npos) return false;
+    s.remove_prefix(at + key.size());
+    if (!s.empty() && s.front() == 'n') s.remove_prefix(1);
+    return parse_number(s, x);
+}
+
+struct Reader {
+    std::function<void(size_t)> node;
+    std::function<void(size_t, size_t, int)> edge;
+};
+
+bool read_dot_line(std::string_view line, const Reader& reader) {
+    skip_spaces(line);
+    if (line.empty() || line.front() == '{' || line.front() == '}' ||
+        line.front() == '#' || line.substr(0, 2) == "//" ||
+        line.substr(0, 7) == "digraph")
+        return true;
+    size_t u = 0, v = 0;
+    int weight = 1;
+    if (!parse_number(line, u)) return false;
+    if (!consume(line, "->")) {
+        reader.node(u);
+        return true;
+    }
+    if (!parse_number(line, v)) return false;
+    if (consume(line, "[")) {
+        if (!consume(line, "weight") || !consume(line, "=") ||
+            !parse_number(line, weight))
+            return false;
+    }
+    reader.edge(u, v, weight);
+    return true;
+}
+
+bool read_graphml_line(std::string_view line, const Reader& reader) {
+    size_t u = 0, v = 0;
+    if (line.find("<node") != std::string_view::npos) {
+        if (!parse_attribute(line, "id=\"", u)) return false;
+        reader.node(u);
+    } else if (line.find("<edge") != std::string_view::npos) {
+        if (!parse_attribute(line, "source=\"", u) ||
+            !parse_attribute(line, "target=\"", v))
+            return false;
+        int weight = 1;
+        auto at = line.find("key=\"weight\">");
+        if (at != std::string_view::npos) {
+            auto rest = line.substr(at + 13);
+            if (!parse_number(rest, weight)) return false;
+        }
+        reader.edge(u, v, weight);
+    }
+    return true;
+}
+
+bool read_json_line(std::string_view line, const Reader& reader) {
+    size_t V = 0;
+    if (parse_attribute(line, "\"nodes\":", V) && V > 0) reader.node(V - 1);
+    for (auto at = line.find('['); at != std::string_view::npos;
+         at = line.find('[')) {
+        line.remove_prefix(at + 1);
+        auto rest = line;
+        skip_spaces(rest);
+        if (rest.empty() || rest.front() < '0' || rest.front() > '9')
+            continue;
+        size_t u = 0, v = 0;
+        int weight = 1;
+        if (!parse_number(rest, u) || !consume(rest, ",") ||
+            !parse_number(rest, v))
+            return false;
+        if (consume(rest, ",") && !parse_number(rest, weight)) return false;
+        if (!consume(rest, "]")) return false;
+        reader.edge(u, v, weight);
+        line = rest;
+    }
+    return true;
+}
+
+bool read_lines(std::istream& in, GraphFormat format, const Reader& reader) {
+    LineReader lines(in);
+    std::string_view line{};
+    while (lines.next(line)) {
+        bool ok = true;
+        switch (format) {
+            case GraphFormat::dot:
+                ok = read_dot_line(line, reader);
+                break;
+            case GraphFormat::graphml:
+                ok = read_graphml_line(line, reader);
+                break;
+            case GraphFormat::json:
+                ok = read_json_line(line, reader);
+                break;
+        }
+        if (!ok) return false;
+    }
+    return true;
+}
+}  // namespace
+
+bool write_graph(std::ostream& out, const DirectedGraph& graph,
+                 GraphFormat format, const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("write_graph");
+    return graph.with_cached_csr([&](const auto& csr) {
+        return write_stream(out, csr, nullptr, format, policy);
+    });
+}
+
+bool write_graph(std::ostream& out, const DiWeightedGraph& graph,
+                 GraphFormat format, const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("write_weighted_graph");
+    return graph.with_cached_csr([&](const auto& csr) {
+        const auto weights = csr_weights(graph, csr);
+        return write_stream(out, csr, &weights, format, policy);
+    });
+}
+
+bool write_graph(const std::string& path, const DirectedGraph& graph,
+                 GraphFormat format, const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("write_graph");
+    return graph.with_cached_csr([&](const auto& csr) {
+        return write_file(path, csr, nullptr, format, policy);
+    });
+}
+
+bool write_graph(const std::string& path, const DiWeightedGraph& graph,
+                 GraphFormat format, const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("write_weighted_graph");
+    return graph.with_cached_csr([&](const auto& csr) {
+        const auto weights = csr_weights(graph, csr);
+        return write_file(path, csr, &weights, format, policy);
+    });
+}
+
+size_t write_graph_chunks(const std::string& path, const DirectedGraph& graph,
+                          GraphFormat format, size_t chunk_bytes,
+                          const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("write_graph_chunks");
+    return graph.with_cached_csr([&](const auto& csr) {
+        return write_chunks(path, csr, nullptr, format, chunk_bytes, policy);
+    });
+}
+
+size_t write_graph_chunks(const std::string& path,
+                          const DiWeightedGraph& graph, GraphFormat format,
+                          size_t chunk_bytes, const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("write_weighted_graph_chunks");
+    return graph.with_cached_csr([&](const auto& csr) {
+        const auto weights = csr_weights(graph, csr);
+        return write_chunks(path, csr, &weights, format, chunk_bytes, policy);
+    });
+}
+
+std::pair<bool, DirectedGraph> read_graph(std::istream& in,
+                                          GraphFormat format) {
+    GRAPH_SDK_RECORD("read_graph");
+    Adjacency adjacency{};
+    auto grow = [&](size_t v) {
+        if (v >= adjacency.size()) adjacency.resize(v + 1);
+    };
+    Reader reader{grow, [&](size_t u, size_t v, int) {
+                      grow(std::max(u, v));
+                      adjacency[u].insert(v);
+                  }};
+    if (!read_lines(in, format, reader))
+        return std::make_pair(false, DirectedGraph{});
+    return std::make_pair(true, DirectedGraph(adjacency));
+}
+
+std::pair<bool, DiWeightedGraph> read_weighted_graph(std::istream& in,
+                                                     GraphFormat format) {
+    GRAPH_SDK_RECORD("read_weighted_graph");
+    WeightedEdges edges{};
+    Reader reader{[](size_t) {},
+                  [&](size_t u, size_t v, int weight) {
+                      edges[{u, v}] = weight;
+                  }};
+    if (!read_lines(in, format, reader))
+        return std::make_pair(false, DiWeightedGraph{});
+    return std::make_pair(true, DiWeightedGraph(edges));
+}
+
+std::pair<bool, DirectedGraph> read_graph(const std::string& path,
+                                          GraphFormat format) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return std::make_pair(false, DirectedGraph{});
+    return read_graph(in, format);
+}
+
+std::pair<bool, DiWeightedGraph> read_weighted_graph(const std::string& path,
+                                                     GraphFormat format) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return std::make_pair(false, DiWeightedGraph{});
+    return read_weighted_graph(in, format);
+}
+}  // namespace graph_sdk
@@ -0,0 +1,306 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include "../include/graph_service.h"
+#include "../include/instrument.h"
+#include "../include/paint.h"
+#include "../include/topological_levels.h"
+
+namespace graph_sdk {
+
+namespace {
+void put(std::string& out, uint64_t x, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i)
+        out.push_back(char((x >> (8 * i)) & 0xff));
+}
+
+uint64_t get(const char* in, size_t bytes) {
+    uint64_t x = 0;
+    for (size_t i = 0; i < bytes; ++i)
+        x |= uint64_t(uint8_t(in[i])) << (8 * i);
+    return x;
+}
+
+// Builds a derived result outside any lock; concurrent builders all return
+// the one published first.
+template <class T, class Compute>
+std::shared_ptr<const T> derive(std::shared_ptr<const T>& slot,
+                                Compute&& compute) {
+    auto current = std::atomic_load(&slot);
+    if (current) return current;
+    auto built = std::make_shared<const T>(compute());
+    if (std::atomic_compare_exchange_strong(&slot, &current, built))
+        return built;
+    return current;
+}
+
+size_t argument_num(Opcode opcode) {
+    switch (opcode) {
+        case Opcode::reachable:
+        case Opcode::shortest_path:
+        case Opcode::max_flow:
+        case Opcode::add_edge:
+        case Opcode::remove_edge:
+            return 2;
+        case Opcode::scc_id:
+        case Opcode::topological_level:
+            return 1;
+        default:
+            return 0;
+    }
+}
+}  // namespace
+
+size_t LatencyHistogram::bucket(uint64_t ns) {
+    if (ns < 16) return size_t(ns);
+    const size_t k = 63 - __builtin_clzll(ns);
+    const size_t sub = (ns >> (k - 3)) & 7;
+    return std::min(bucket_num - 1, 16 + (k - 4) * 8 + sub);
+}
+
+uint64_t LatencyHistogram::upper_bound(size_t bucket) {
+    if (bucket < 16) return bucket;
+    const size_t k = (bucket - 16) / 8 + 4, sub = (bucket - 16) % 8;
+    return ((8 + sub + 1) << (k - 3)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    buckets_[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    auto known = max_.load(std::memory_order_relaxed);
+    while (known < ns && !max_.compare_exchange_weak(known, ns)) {
+    }
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    const auto total = count();
+    if (total == 0) return 0;
+    const auto rank = uint64_t(q * double(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < bucket_num; ++b) {
+        seen += buckets_[b].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(upper_bound(b), max());
+    }
+    return max();
+}
+
+struct GraphService::Materialised {
+    size_t version{};
+    DirectedGraph graph{};
+    // max(size_t) for nodes on or behind a cycle
+    std::shared_ptr<const std::vector<size_t>> level{};
+    std::shared_ptr<const DiWeightedGraph> network{};
+    std::shared_ptr<const uint64_t> certificate{};
+};
+
+GraphService::GraphService(const DirectedGraph& graph,
+                           const ExecutionPolicy& policy)
+    : graph_(graph), policy_(policy) {}
+
+GraphService::~GraphService() = default;
+
+// One materialised version is kept; a request on an older snapshot than
+// the kept one builds a private copy instead of evicting it.
+std::shared_ptr<GraphService::Materialised> GraphService::materialise(
+    const VersionedGraph::Snapshot& snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(materialised_mutex_);
+        if (materialised_ && materialised_->version == snapshot.version())
+            return materialised_;
+    }
+    GRAPH_SDK_PHASE("materialise");
+    auto fresh = std::make_shared<Materialised>();
+    fresh->version = snapshot.version();
+    fresh->graph = snapshot.to_graph();
+    std::lock_guard<std::mutex> lock(materialised_mutex_);
+    if (materialised_ && materialised_->version == fresh->version)
+        return materialised_;
+    if (!materialised_ || materialised_->version < fresh->version)
+        materialised_ = fresh;
+    return fresh;
+}
+
+Status GraphService::execute(Opcode opcode, const uint64_t* arguments,
+                             size_t argument_num, std::string& payload) {
+    // search scratch of the calling thread, sized to the largest version
+    thread_local Workspace workspace{};
+    auto snapshot = graph_.snapshot();
+    const auto V = snapshot.node_num();
+    // add_edge may introduce nodes, at most doubling the node count
+    const auto limit = opcode == Opcode::add_edge ? 2 * V + 1024 : V;
+    for (size_t i = 0; i < argument_num; ++i) {
+        if (arguments[i] >= limit) return Status::bad_request;
+    }
+    switch (opcode) {
+        case Opcode::ping:
+            return Status::ok;
+        case Opcode::reachable: {
+            auto m = materialise(snapshot);
+            put(payload,
+                m->graph.is_reachable(workspace, arguments[0], arguments[1]),
+                1);
+            return Status::ok;
+        }
+        case Opcode::scc_id: {
+            auto m = materialise(snapshot);
+            auto components = m->graph.cached_scc(policy_);
+            put(payload, components->second[arguments[0]], 8);
+            return Status::ok;
+        }
+        case Opcode::shortest_path: {
+            auto m = materialise(snapshot);
+            std::vector<size_t> path{};
+            if (!m->graph.shortest_path(workspace, arguments[0], arguments[1],
+                                        path))
+                return Status::no_result;
+            put(payload, path.size(), 4);
+            for (auto v : path) put(payload, v, 8);
+            return Status::ok;
+        }
+        case Opcode::topological_level: {
+            auto m = materialise(snapshot);
+            auto node_level = derive(m->level, [&]() {
+                auto levels = m->graph.cached_topological_levels(policy_);
+                std::vector<size_t> level(V,
+                                          std::numeric_limits<size_t>::max());
+                for (size_t l = 0; l < levels->level_num(); ++l) {
+                    for (auto v : levels->level(l)) level[v] = l;
+                }
+                return level;
+            });
+            auto level = (*node_level)[arguments[0]];
+            if (level == std::numeric_limits<size_t>::max())
+                return Status::no_result;
+            put(payload, level, 8);
+            return Status::ok;
+        }
+        case Opcode::max_flow: {
+            if (arguments[0] == arguments[1]) return Status::bad_request;
+            auto m = materialise(snapshot);
+            auto network = derive(m->network, [&]() {
+                WeightedEdges edges{};
+                for (size_t v = 0; v < V; ++v) {
+                    for (auto x : snapshot.neighbours(v)) edges[{v, x}] = 1;
+                }
+                return DiWeightedGraph(edges);
+            });
+            const auto nodes = network->with_cached_csr(
+                [](const auto& csr) { return csr.node_num(); });
+            int64_t flow = 0;
+            if (arguments[0] < nodes && arguments[1] < nodes)
+                flow = network->max_flow(arguments[0], arguments[1], policy_);
+            put(payload, uint64_t(flow), 8);
+            return Status::ok;
+        }
+        case Opcode::certificate: {
+            auto m = materialise(snapshot);
+            auto certificate = derive(m->certificate, [&]() {
+                return refinement_certificate(m->graph, policy_);
+            });
+            put(payload, *certificate, 8);
+            return Status::ok;
+        }
+        case Opcode::add_edge: {
+            std::lock_guard<std::mutex> lock(writer_mutex_);
+            put(payload, graph_.add_edge({arguments[0], arguments[1]}), 1);
+            return Status::ok;
+        }
+        case Opcode::remove_edge: {
+            std::lock_guard<std::mutex> lock(writer_mutex_);
+            put(payload, graph_.remove_edge({arguments[0], arguments[1]}),
+                1);
+            return Status::ok;
+        }
+        case Opcode::commit: {
+            std::lock_guard<std::mutex> lock(writer_mutex_);
+            put(payload, graph_.commit(), 8);
+            return Status::ok;
+        }
+        case Opcode::stats:
+            put(payload, opcode_num, 4);
+            for (size_t k = 0; k < opcode_num; ++k) {
+                const auto& histogram = latency_[k];
+                put(payload, k, 1);
+                put(payload, histogram.count(), 8);
+                for (auto q : {0.5, 0.9, 0.99})
+                    put(payload, histogram.percentile(q), 8);
+                put(payload, histogram.max(), 8);
+            }
+            return Status::ok;
+    }
+    return Status::bad_request;
+}
+
+std::string GraphService::handle(std::string_view request) {
+    const auto start = std::chrono::steady_clock::now();
+    uint32_t tag = 0;
+    Status status = Status::bad_request;
+    std::string payload{};
+    size_t opcode = opcode_num;
+    if (request.size() >= 5) {
+        tag = uint32_t(get(request.data(), 4));
+        opcode = uint8_t(request[4]);
+        const auto rest = request.size() - 5;
+        if (opcode < opcode_num && rest % 8 == 0 &&
+            rest / 8 == argument_num(Opcode(opcode))) {
+            uint64_t arguments[2] = {0, 0};
+            for (size_t i = 0; i < rest / 8; ++i)
+                arguments[i] = get(request.data() + 5 + 8 * i, 8);
+            status = execute(Opcode(opcode), arguments, rest / 8, payload);
+        }
+    }
+    std::string reply{};
+    reply.reserve(9 + payload.size());
+    put(reply, 5 + payload.size(), 4);
+    put(reply, tag, 4);
+    put(reply, uint8_t(status), 1);
+    reply += payload;
+    if (opcode < opcode_num) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        latency_[opcode].record(uint64_t(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                .count()));
+    }
+    return reply;
+}
+
+RequestExecutor::RequestExecutor(GraphService& service, size_t threads)
+    : service_(service) {
+    for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i)
+        threads_.emplace_back([this]() { run(); });
+}
+
+RequestExecutor::~RequestExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    ready_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+void RequestExecutor::submit(std::string request, Reply reply) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.emplace_back(std::move(request), std::move(reply));
+    }
+    ready_.notify_one();
+}
+
+void RequestExecutor::run() {
+    while (true) {
+        std::pair<std::string, Reply> job{};
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [&]() { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        job.second(service_.handle(job.first));
+    }
+}
+}  // namespace graph_sdk
@@ -0,0 +1,294 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include "../include/instrument.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace graph_sdk {
+
+namespace {
+enum Counter { vertices, edges, cells, allocations, bytes, counter_num };
+static_assert(counter_num == CallContext::counter_num, "counter count");
+
+// Counts go to a per-thread buffer first, which is added to the context
+// whenever the thread leaves it, so threads sharing a context do not
+// contend on its cache line.
+thread_local CallContext* current_context = nullptr;
+thread_local uint64_t pending[counter_num]{};
+thread_local ScopedRecord* active_record = nullptr;
+thread_local AlgorithmStats last_record{};
+
+std::atomic<bool> hardware_on{false};
+
+std::mutex history_mutex{};
+std::deque<AlgorithmStats> records{};
+
+void count(Counter k, uint64_t n) {
+    if (current_context != nullptr) pending[k] += n;
+}
+
+void flush() {
+    if (current_context == nullptr) return;
+    for (int k = 0; k < counter_num; ++k) {
+        if (pending[k] == 0) continue;
+        current_context->counters[k].fetch_add(pending[k],
+                                               std::memory_order_relaxed);
+        pending[k] = 0;
+    }
+}
+
+void switch_context(CallContext* context) {
+    flush();
+    current_context = context;
+}
+
+void raise_peak(CallContext& context, int64_t live) {
+    auto peak = context.peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak &&
+           !context.peak_bytes.compare_exchange_weak(peak, live)) {
+    }
+}
+
+std::string escape(const std::string& s) {
+    std::string out{};
+    for (auto c : s) {
+        if (c == '"' || c == '\\') out.push_back('\\');
+        out.push_back(c);
+    }
+    return out;
+}
+
+#ifdef __linux__
+int open_event(uint64_t config, int group) {
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = group == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return static_cast<int>(
+        syscall(__NR_perf_event_open, &attr, 0, -1, group, 0));
+}
+#endif
+}  // namespace
+
+std::string AlgorithmStats::to_json() const {
+    std::ostringstream os;
+    os << "{\"algorithm\":\"" << escape(algorithm) << "\""
+       << ",\"vertices_visited\":" << vertices_visited
+       << ",\"edges_visited\":" << edges_visited
+       << ",\"cells_scanned\":" << cells_scanned
+       << ",\"allocations\":" << allocations
+       << ",\"allocated_bytes\":" << allocated_bytes
+       << ",\"peak_scratch_bytes\":" << peak_scratch_bytes
+       << ",\"seconds\":" << seconds << ",\"phases\":{";
+    for (size_t i = 0; i < phases.size(); ++i) {
+        os << (i ? "," : "") << "\"" << escape(phases[i].first)
+           << "\":" << phases[i].second;
+    }
+    os << "}";
+    if (hardware_counters) {
+        os << ",\"cycles\":" << cycles << ",\"cache_misses\":" << cache_misses
+           << ",\"branch_misses\":" << branch_misses;
+    }
+    os << "}";
+    return os.str();
+}
+
+bool Instrumentation::enabled() {
+#ifdef GRAPH_SDK_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Instrumentation::enable_hardware_counters(bool on) { hardware_on = on; }
+
+AlgorithmStats Instrumentation::last() {
+    return last_record;
+}
+
+std::vector<AlgorithmStats> Instrumentation::history() {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    return {records.begin(), records.end()};
+}
+
+std::vector<AlgorithmStats> Instrumentation::drain() {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    std::vector<AlgorithmStats> drained(
+        std::make_move_iterator(records.begin()),
+        std::make_move_iterator(records.end()));
+    records.clear();
+    return drained;
+}
+
+void Instrumentation::clear() {
+    std::lock_guard<std::mutex> lock(history_mutex);
+    records.clear();
+}
+
+void Instrumentation::dump_json(std::ostream& os) {
+    auto stats = Instrumentation::history();
+    os << "[";
+    for (size_t i = 0; i < stats.size(); ++i) {
+        os << (i ? ",\n" : "\n") << stats[i].to_json();
+    }
+    os << "\n]\n";
+}
+
+void Instrumentation::count_vertices(uint64_t n) { count(vertices, n); }
+void Instrumentation::count_edges(uint64_t n) { count(edges, n); }
+void Instrumentation::count_cells(uint64_t n) { count(cells, n); }
+
+CallContext* CallContext::current() { return current_context; }
+
+ScopedContext::ScopedContext(CallContext* context)
+    : previous_(current_context) {
+    switch_context(context);
+}
+
+ScopedContext::~ScopedContext() { switch_context(previous_); }
+
+ScopedRecord::ScopedRecord(const char* algorithm) {
+    stats_.algorithm = algorithm;
+    previous_ = active_record;
+    active_record = this;
+    parent_ = current_context;
+    switch_context(&context_);
+#ifdef __linux__
+    if (hardware_on) {
+        perf_fd_[0] = open_event(PERF_COUNT_HW_CPU_CYCLES, -1);
+        if (perf_fd_[0] != -1) {
+            perf_fd_[1] = open_event(PERF_COUNT_HW_CACHE_MISSES, perf_fd_[0]);
+            perf_fd_[2] = open_event(PERF_COUNT_HW_BRANCH_MISSES, perf_fd_[0]);
+            ioctl(perf_fd_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(perf_fd_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+#endif
+    begin_ = std::chrono::steady_clock::now();
+}
+
+ScopedRecord::~ScopedRecord() {
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - begin_;
+    stats_.seconds = d.count();
+#ifdef __linux__
+    if (perf_fd_[0] != -1) {
+        ioctl(perf_fd_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        struct {
+            uint64_t nr;
+            uint64_t values[3];
+        } group{};
+        if (read(perf_fd_[0], &group, sizeof(group)) > 0 && group.nr == 3) {
+            stats_.hardware_counters = true;
+            stats_.cycles = group.values[0];
+            stats_.cache_misses = group.values[1];
+            stats_.branch_misses = group.values[2];
+        }
+        for (auto fd : perf_fd_)
+            if (fd != -1) close(fd);
+    }
+#endif
+    // the workers of this call flushed before run_workers returned
+    switch_context(parent_);
+    uint64_t counters[counter_num]{};
+    for (int k = 0; k < counter_num; ++k)
+        counters[k] = context_.counters[k].load();
+    const auto live = context_.live_bytes.load();
+    const auto peak = context_.peak_bytes.load();
+    stats_.vertices_visited = counters[vertices];
+    stats_.edges_visited = counters[edges];
+    stats_.cells_scanned = counters[cells];
+    stats_.allocations = counters[allocations];
+    stats_.allocated_bytes = counters[bytes];
+    stats_.peak_scratch_bytes = uint64_t(std::max<int64_t>(peak, 0));
+    // a nested call is part of its caller, its peak sits on top of what the
+    // caller had live when it started
+    if (parent_ != nullptr) {
+        for (int k = 0; k < counter_num; ++k)
+            parent_->counters[k].fetch_add(counters[k]);
+        raise_peak(*parent_, parent_->live_bytes.load() + peak);
+        parent_->live_bytes.fetch_add(live);
+    }
+
+    active_record = previous_;
+    last_record = stats_;
+    std::lock_guard<std::mutex> lock(history_mutex);
+    records.push_back(std::move(stats_));
+    if (records.size() > Instrumentation::history_limit) records.pop_front();
+}
+
+void ScopedRecord::add_phase(const char* name, double seconds) {
+    for (auto& [phase, time] : stats_.phases) {
+        if (phase == name) {
+            time += seconds;
+            return;
+        }
+    }
+    stats_.phases.emplace_back(name, seconds);
+}
+
+ScopedRecord* ScopedRecord::active() { return active_record; }
+
+}  // namespace graph_sdk
+
+#ifdef GRAPH_SDK_INSTRUMENT
+// Allocation accounting: every block carries its size in a small header so
+// the live byte count, and with it the scratch peak, can be maintained.
+namespace {
+constexpr std::size_t header = alignof(std::max_align_t);
+
+void note_alloc(std::size_t size) {
+    auto* context = graph_sdk::current_context;
+    if (context == nullptr) return;
+    graph_sdk::count(graph_sdk::allocations, 1);
+    graph_sdk::count(graph_sdk::bytes, size);
+    const auto live = context->live_bytes.fetch_add(int64_t(size)) +
+                      int64_t(size);
+    graph_sdk::raise_peak(*context, live);
+}
+
+// charged to the context of the freeing thread
+void note_free(std::size_t size) {
+    if (auto* context = graph_sdk::current_context)
+        context->live_bytes.fetch_sub(int64_t(size));
+}
+}  // namespace
+
+void* operator new(std::size_t size) {
+    auto* p = static_cast<unsigned char*>(std::malloc(size + header));
+    if (p == nullptr) throw std::bad_alloc();
+    *reinterpret_cast<std::size_t*>(p) = size;
+    note_alloc(size);
+    return p + header;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) return;
+    auto* p = static_cast<unsigned char*>(ptr) - header;
+    note_free(*reinterpret_cast<std::size_t*>(p));
+    std::free(p);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept { operator delete(ptr); }
+#endif
@@ -0,0 +1,221 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include "../include/instrument.h"
+#include "../include/k_shortest_paths.h"
+
+namespace graph_sdk {
+
+namespace {
+constexpr auto unreached = std::numeric_limits<int64_t>::max();
+}  // namespace
+
+KShortestPaths::KShortestPaths(const DiWeightedGraph& graph, size_t source,
+                               size_t sink, const ExecutionPolicy& policy)
+    : source_(source),
+      sink_(sink),
+      policy_(policy),
+      scratch_(std::max<size_t>(policy.threads(), 1)) {
+    GRAPH_SDK_RECORD("k_shortest_paths");
+    const auto& weighted = graph.extract_weighted_edges();
+    if (graph.fits_csr32()) {
+        graph_ = graph.cached_csr();
+        build(*graph_, *graph.cached_reverse_csr(), weighted);
+    } else {
+        wide_graph_ = graph.cached_wide_csr();
+        build(*wide_graph_, *graph.cached_wide_reverse_csr(), weighted);
+    }
+}
+
+template <class Graph>
+void KShortestPaths::build(const Graph& graph, const Graph& reverse,
+                           const WeightedEdges& weighted) {
+    const auto V = graph.node_num();
+    weights_.resize(graph.edge_num());
+    for (size_t v = 0; v < V; ++v) {
+        for (auto e = graph.offsets()[v]; e < graph.offsets()[v + 1]; ++e) {
+            weights_[e] = weighted.at({v, size_t(graph.targets()[e])});
+            assert(weights_[e] >= 0);
+        }
+    }
+    distance_.assign(V, unreached);
+    successor_.assign(V, V);
+    // nodes without an edge are unknown to a DiWeightedGraph
+    if (source_ >= V || sink_ >= V) return;
+
+    // Dijkstra towards the sink over the reverse graph
+    using Entry = std::pair<int64_t, size_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>
+        heap{};
+    distance_[sink_] = 0;
+    heap.emplace(0, sink_);
+    while (!heap.empty()) {
+        auto [d, v] = heap.top();
+        heap.pop();
+        if (d != distance_[v]) continue;
+        GRAPH_SDK_COUNT_EDGES(reverse.degree(v));
+        for (size_t x : reverse.neighbours(v)) {
+            auto candidate = d + weighted.at({x, v});
+            if (candidate < distance_[x]) {
+                distance_[x] = candidate;
+                successor_[x] = v;
+                heap.emplace(candidate, x);
+            }
+        }
+    }
+}
+
+// Deviation from `path` at nodes[i]: the root nodes[0..i] is kept, the
+// nodes before nodes[i] are removed, and so is every edge leaving
+// nodes[i] that an accepted path with the same root takes.
+bool KShortestPaths::spur(const Candidate& path, size_t i, Scratch& scratch,
+                          Candidate& result) const {
+    if (wide_graph_) return spur(*wide_graph_, path, i, scratch, result);
+    return spur(*graph_, path, i, scratch, result);
+}
+
+template <class Graph>
+bool KShortestPaths::spur(const Graph& graph, const Candidate& path,
+                          size_t i, Scratch& scratch,
+                          Candidate& result) const {
+    const auto& nodes = path.nodes;
+    const auto& offsets = graph.offsets();
+    const auto& targets = graph.targets();
+    const auto from = nodes[i];
+    if (distance_[from] == unreached) return false;
+    std::vector<size_t> removed{};
+    for (const auto& other : accepted_) {
+        if (other.nodes.size() > i + 1 &&
+            std::equal(nodes.begin(), nodes.begin() + i + 1,
+                       other.nodes.begin()))
+            removed.push_back(other.nodes[i + 1]);
+    }
+    auto is_removed = [&](size_t x) {
+        return std::find(removed.begin(), removed.end(), x) != removed.end();
+    };
+    // state: 1 settled, 2 removed
+    scratch.parent.reset(graph.node_num());
+    scratch.cost.reset(graph.node_num());
+    scratch.state.reset(graph.node_num());
+    int64_t root_cost = 0;
+    for (size_t j = 0; j < i; ++j) {
+        scratch.state.set(nodes[j], 2);
+        auto row = targets.begin() + offsets[nodes[j]];
+        auto end = targets.begin() + offsets[nodes[j] + 1];
+        root_cost += weights_[std::lower_bound(row, end, nodes[j + 1]) -
+                              targets.begin()];
+    }
+    result.nodes.assign(nodes.begin(), nodes.begin() + i);
+    result.deviation = i;
+
+    // the shortest path tree answers when its path avoids the removals
+    bool tree = !is_removed(successor_[from]);
+    for (auto v = from; tree && v != sink_; v = successor_[v])
+        tree = scratch.state.get(successor_[v]) != 2;
+    if (tree) {
+        for (auto v = from; v != sink_; v = successor_[v])
+            result.nodes.push_back(v);
+        result.nodes.push_back(sink_);
+        result.cost = root_cost + distance_[from];
+        return true;
+    }
+
+    // A* under the removals, guided by the distances of the whole graph
+    auto& heap = scratch.heap;
+    heap.clear();
+    const auto later = std::greater<std::pair<int64_t, size_t>>();
+    scratch.cost.set(from, 0);
+    scratch.parent.set(from, from + 1);
+    heap.emplace_back(distance_[from], from);
+    bool found = false;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        auto v = heap.back().second;
+        heap.pop_back();
+        if (scratch.state.get(v)) continue;
+        scratch.state.set(v, 1);
+        if (v == sink_) {
+            found = true;
+            break;
+        }
+        const auto g = scratch.cost.get(v);
+        GRAPH_SDK_COUNT_EDGES(graph.degree(v));
+        for (auto e = offsets[v]; e < offsets[v + 1]; ++e) {
+            size_t x = targets[e];
+            if (scratch.state.get(x) || distance_[x] == unreached) continue;
+            if (v == from && is_removed(x)) continue;
+            auto candidate = g + weights_[e];
+            if (scratch.parent.get(x) && scratch.cost.get(x) <= candidate)
+                continue;
+            scratch.cost.set(x, candidate);
+            scratch.parent.set(x, v + 1);
+            heap.emplace_back(candidate + distance_[x], x);
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+    }
+    if (!found) return false;
+    const auto first = result.nodes.size();
+    for (auto v = sink_; v != from; v = scratch.parent.get(v) - 1)
+        result.nodes.push_back(v);
+    result.nodes.push_back(from);
+    std::reverse(result.nodes.begin() + first, result.nodes.end());
+    result.cost = root_cost + scratch.cost.get(sink_);
+    return true;
+}
+
+std::pair<bool, WeightedPath> KShortestPaths::next() {
+    if (!started_) {
+        started_ = true;
+        if (source_ < distance_.size() && sink_ < distance_.size() &&
+            distance_[source_] != unreached) {
+            Candidate first{distance_[source_], {}, 0};
+            for (auto v = source_; v != sink_; v = successor_[v])
+                first.nodes.push_back(v);
+            first.nodes.push_back(sink_);
+            candidates_.insert(std::move(first));
+        }
+    } else if (!accepted_.empty()) {
+        // spurs of the path returned last
+        const auto& last = accepted_.back();
+        const auto begin = last.deviation, end = last.nodes.size() - 1;
+        if (begin < end) {
+            std::vector<Candidate> found(end - begin);
+            std::vector<char> valid(end - begin, 0);
+            std::atomic<size_t> next{begin};
+            run_workers(policy_, end - begin, [&](size_t worker) {
+                for (auto i = next.fetch_add(1); i < end;
+                     i = next.fetch_add(1))
+                    valid[i - begin] = spur(last, i, scratch_[worker],
+                                            found[i - begin]);
+            });
+            for (size_t k = 0; k < found.size(); ++k) {
+                if (valid[k]) candidates_.insert(std::move(found[k]));
+            }
+        }
+    }
+    if (candidates_.empty()) return {false, WeightedPath{}};
+    auto best = candidates_.extract(candidates_.begin());
+    accepted_.push_back(std::move(best.value()));
+    return {true, WeightedPath{accepted_.back().cost, accepted_.back().nodes}};
+}
+
+std::vector<WeightedPath> k_shortest_paths(const DiWeightedGraph& graph,
+                                           size_t source, size_t sink,
+                                           size_t k,
+                                           const ExecutionPolicy& policy) {
+    std::vector<WeightedPath> paths{};
+    KShortestPaths generator(graph, source, sink, policy);
+    while (paths.size() < k) {
+        auto [more, path] = generator.next();
+        if (!more) break;
+        paths.push_back(std::move(path));
+    }
+    return paths;
+}
+}  // namespace graph_sdk
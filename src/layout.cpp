@@ -0,0 +1,343 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <tuple>
+
+#include "../include/csr.h"
+#include "../include/instrument.h"
+#include "../include/layout.h"
+
+namespace graph_sdk {
+
+size_t QuadTree::make_child(size_t c, size_t quadrant) {
+    const auto h = cells_[c].half / 2.0;
+    Cell child{};
+    child.cx = cells_[c].cx + ((quadrant & 1) ? h : -h);
+    child.cy = cells_[c].cy + ((quadrant & 2) ? h : -h);
+    child.half = h;
+    cells_.push_back(child);
+    cells_[c].child[quadrant] = int32_t(cells_.size() - 1);
+    return cells_.size() - 1;
+}
+
+void QuadTree::build(const std::vector<double>& x,
+                     const std::vector<double>& y,
+                     const std::vector<double>& mass) {
+    cells_.clear();
+    if (x.empty()) return;
+    auto [min_x, max_x] = std::minmax_element(x.begin(), x.end());
+    auto [min_y, max_y] = std::minmax_element(y.begin(), y.end());
+    Cell root{};
+    root.cx = (*min_x + *max_x) / 2.0;
+    root.cy = (*min_y + *max_y) / 2.0;
+    root.half = std::max(*max_x - *min_x, *max_y - *min_y) / 2.0 + 1e-9;
+    cells_.push_back(root);
+
+    auto quadrant = [&](size_t c, size_t i) {
+        return size_t(x[i] >= cells_[c].cx) + 2 * size_t(y[i] >= cells_[c].cy);
+    };
+    for (size_t i = 0; i < x.size(); ++i) {
+        size_t c = 0;
+        for (size_t depth = 0;; ++depth) {
+            auto& cell = cells_[c];
+            const bool empty = cell.point < 0 && !cell.bucket &&
+                               std::all_of(cell.child, cell.child + 4,
+                                           [](int32_t k) { return k < 0; });
+            cell.mass += mass[i];
+            cell.mx += mass[i] * x[i];
+            cell.my += mass[i] * y[i];
+            if (empty) {
+                cell.point = int32_t(i);
+                break;
+            }
+            if (cell.bucket) break;
+            if (cell.point >= 0) {
+                if (depth >= max_depth) {
+                    cell.point = -1;
+                    cell.bucket = true;
+                    break;
+                }
+                const auto k = size_t(cell.point);
+                cell.point = -1;
+                auto moved = make_child(c, quadrant(c, k));
+                cells_[moved].point = int32_t(k);
+                cells_[moved].mass = mass[k];
+                cells_[moved].mx = mass[k] * x[k];
+                cells_[moved].my = mass[k] * y[k];
+            }
+            const auto q = quadrant(c, i);
+            auto next = cells_[c].child[q];
+            c = next >= 0 ? size_t(next) : make_child(c, q);
+        }
+    }
+}
+
+void QuadTree::repulsion(size_t i, const std::vector<double>& x,
+                         const std::vector<double>& y,
+                         const std::vector<double>& mass, double theta,
+                         double strength, double& fx, double& fy) const {
+    fx = fy = 0.0;
+    if (cells_.empty()) return;
+    // depth first, at most three siblings wait per level
+    int32_t stack[4 * max_depth + 8];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const auto& cell = cells_[stack[--top]];
+        if (cell.mass == 0.0) continue;
+        const auto dx = x[i] - cell.mx / cell.mass;
+        const auto dy = y[i] - cell.my / cell.mass;
+        const auto d2 = dx * dx + dy * dy;
+        const bool leaf = cell.point >= 0 || cell.bucket;
+        if (leaf && (cell.point == int32_t(i) || d2 < 1e-24)) continue;
+        if (leaf || 4.0 * cell.half * cell.half < theta * theta * d2) {
+            const auto f = strength * mass[i] * cell.mass / d2;
+            fx += dx * f;
+            fy += dy * f;
+            continue;
+        }
+        for (auto k : cell.child) {
+            if (k >= 0) stack[top++] = k;
+        }
+    }
+}
+
+namespace {
+// undirected level of the hierarchy
+template <typename NodeId, typename EdgeId>
+struct Level {
+    CsrGraph<NodeId, EdgeId> graph{};
+    // per edge of graph
+    std::vector<double> weight{};
+    std::vector<double> mass{};
+    // node of the next coarser level, empty on the coarsest
+    std::vector<NodeId> parent{};
+};
+
+template <typename NodeId, typename EdgeId>
+Level<NodeId, EdgeId> contract(const Level<NodeId, EdgeId>& fine,
+                               const std::vector<NodeId>& group,
+                               size_t groups) {
+    std::vector<std::tuple<NodeId, NodeId, double>> edges{};
+    for (size_t u = 0; u < fine.graph.node_num(); ++u) {
+        for (auto k = fine.graph.offsets()[u]; k < fine.graph.offsets()[u + 1];
+             ++k) {
+            auto a = group[u], b = group[fine.graph.targets()[k]];
+            if (a != b) edges.emplace_back(a, b, fine.weight[k]);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    Level<NodeId, EdgeId> coarse{};
+    std::vector<EdgeId> offsets(groups + 1, 0);
+    std::vector<NodeId> targets{};
+    for (size_t k = 0; k < edges.size();) {
+        auto [a, b, w] = edges[k];
+        for (++k; k < edges.size() && std::get<0>(edges[k]) == a &&
+                  std::get<1>(edges[k]) == b;
+             ++k)
+            w += std::get<2>(edges[k]);
+        targets.push_back(b);
+        coarse.weight.push_back(w);
+        offsets[a + 1] += 1;
+    }
+    for (size_t a = 0; a < groups; ++a) offsets[a + 1] += offsets[a];
+    coarse.graph =
+        CsrGraph<NodeId, EdgeId>(std::move(offsets), std::move(targets));
+    coarse.mass.assign(groups, 0.0);
+    for (size_t u = 0; u < fine.mass.size(); ++u)
+        coarse.mass[group[u]] += fine.mass[u];
+    return coarse;
+}
+
+// every node pairs with the unmatched neighbour of heaviest
+// weight / (mass * mass), which keeps coarse masses balanced
+template <typename NodeId, typename EdgeId>
+std::vector<NodeId> heavy_edge_matching(const Level<NodeId, EdgeId>& level,
+                                        size_t& groups) {
+    constexpr auto none = std::numeric_limits<NodeId>::max();
+    const auto V = level.graph.node_num();
+    std::vector<NodeId> group(V, none);
+    groups = 0;
+    for (size_t u = 0; u < V; ++u) {
+        if (group[u] != none) continue;
+        auto best = none;
+        double best_score = 0.0;
+        for (auto k = level.graph.offsets()[u];
+             k < level.graph.offsets()[u + 1]; ++k) {
+            auto v = level.graph.targets()[k];
+            if (group[v] != none) continue;
+            auto score = level.weight[k] / (level.mass[u] * level.mass[v]);
+            if (score > best_score) {
+                best_score = score;
+                best = v;
+            }
+        }
+        group[u] = NodeId(groups);
+        if (best != none) group[best] = NodeId(groups);
+        ++groups;
+    }
+    return group;
+}
+
+// Spring-electrical forces with Hu's adaptive step: every node moves by
+// `step` along its force, the step grows after five energy decreases in a
+// row and shrinks on any increase.
+template <typename NodeId, typename EdgeId>
+void refine(const Level<NodeId, EdgeId>& level, std::vector<double>& x,
+            std::vector<double>& y, size_t iterations,
+            const ExecutionPolicy& policy) {
+    const auto n = level.graph.node_num();
+    if (n <= 1) return;
+    const double K = 1.0, strength = 0.2 * K * K, theta = 0.9;
+    const auto& offsets = level.graph.offsets();
+    const auto& targets = level.graph.targets();
+    std::vector<double> fx(n, 0.0), fy(n, 0.0);
+    QuadTree tree{};
+    double step = K, energy = std::numeric_limits<double>::max();
+    size_t progress = 0;
+    for (size_t iteration = 0; iteration < iterations; ++iteration) {
+        GRAPH_SDK_PHASE("forces");
+        tree.build(x, y, level.mass);
+        parallel_for(policy, 0, n, 256, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                double ax = 0.0, ay = 0.0;
+                tree.repulsion(i, x, y, level.mass, theta, strength, ax, ay);
+                for (auto k = offsets[i]; k < offsets[i + 1]; ++k) {
+                    auto j = targets[k];
+                    auto dx = x[j] - x[i], dy = y[j] - y[i];
+                    auto pull = level.weight[k] * std::hypot(dx, dy) / K;
+                    ax += dx * pull;
+                    ay += dy * pull;
+                }
+                fx[i] = ax;
+                fy[i] = ay;
+            }
+        });
+        double total = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            auto f = std::hypot(fx[i], fy[i]);
+            total += f * f;
+            if (f == 0.0) continue;
+            x[i] += step * fx[i] / f;
+            y[i] += step * fy[i] / f;
+        }
+        if (total < energy) {
+            if (++progress >= 5) {
+                progress = 0;
+                step /= 0.9;
+            }
+        } else {
+            progress = 0;
+            step *= 0.9;
+        }
+        energy = total;
+        if (step < 1e-3 * K) break;
+    }
+}
+
+// multilevel layout of the graph whose cached CSR is csr
+template <typename NodeId, typename EdgeId>
+Layout multilevel_layout(const DirectedGraph& graph,
+                         const CsrGraph<NodeId, EdgeId>& csr,
+                         size_t iterations, unsigned seed,
+                         const ExecutionPolicy& policy) {
+    Layout layout{};
+    const auto V = csr.node_num();
+    if (V == 0) return layout;
+
+    std::vector<Level<NodeId, EdgeId>> levels(1);
+    levels[0].graph = symmetrize(csr);
+    levels[0].weight.assign(levels[0].graph.edge_num(), 1.0);
+    levels[0].mass.assign(V, 1.0);
+    // first level: the condensation of meta_graph()
+    auto components = graph.cached_scc(policy);
+    if (components->first) {
+        constexpr auto none = std::numeric_limits<NodeId>::max();
+        const auto& scc = components->second;
+        std::vector<NodeId> id(V, none);
+        std::vector<NodeId> group(V);
+        size_t groups = 0;
+        for (size_t v = 0; v < V; ++v) {
+            if (id[scc[v]] == none) id[scc[v]] = NodeId(groups++);
+            group[v] = id[scc[v]];
+        }
+        if (groups < V) {
+            levels[0].parent = group;
+            levels.push_back(contract(levels[0], group, groups));
+        }
+    }
+    while (levels.back().graph.node_num() > 32) {
+        size_t groups = 0;
+        auto group = heavy_edge_matching(levels.back(), groups);
+        if (10 * groups > 9 * levels.back().graph.node_num()) break;
+        levels.back().parent = group;
+        levels.push_back(contract(levels.back(), group, groups));
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uniform(-0.5, 0.5);
+    const auto coarsest = levels.back().graph.node_num();
+    const auto side = std::sqrt(double(coarsest));
+    std::vector<double> x(coarsest), y(coarsest);
+    for (size_t v = 0; v < coarsest; ++v) {
+        x[v] = side * uniform(rng);
+        y[v] = side * uniform(rng);
+    }
+    refine(levels.back(), x, y, iterations, policy);
+    for (auto l = levels.size() - 1; l-- > 0;) {
+        const auto& parent = levels[l].parent;
+        std::vector<double> fine_x(parent.size()), fine_y(parent.size());
+        for (size_t v = 0; v < parent.size(); ++v) {
+            fine_x[v] = x[parent[v]] + 0.1 * uniform(rng);
+            fine_y[v] = y[parent[v]] + 0.1 * uniform(rng);
+        }
+        x.swap(fine_x);
+        y.swap(fine_y);
+        refine(levels[l], x, y, std::max<size_t>(iterations / 3, 30),
+               policy);
+    }
+    layout.x = std::move(x);
+    layout.y = std::move(y);
+    return layout;
+}
+}  // namespace
+
+Layout force_directed_layout(const DirectedGraph& graph, size_t iterations,
+                             unsigned seed, const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("force_directed_layout");
+    return graph.with_cached_csr([&](const auto& csr) {
+        return multilevel_layout(graph, csr, iterations, seed, policy);
+    });
+}
+
+bool write_layout(const std::string& path, const DirectedGraph& graph,
+                  const Layout& layout) {
+    std::string text = "# node x y\n";
+    char line[96];
+    for (size_t v = 0; v < layout.node_num(); ++v) {
+        auto n = std::snprintf(line, sizeof(line), "%zu %.9g %.9g\n", v,
+                               layout.x[v], layout.y[v]);
+        text.append(line, size_t(n));
+    }
+    text += "# source target\n";
+    graph.with_cached_csr([&](const auto& csr) {
+        assert(layout.node_num() == csr.node_num());
+        for (size_t v = 0; v < csr.node_num(); ++v) {
+            for (size_t w : csr.neighbours(v)) {
+                auto n =
+                    std::snprintf(line, sizeof(line), "%zu %zu\n", v, w);
+                text.append(line, size_t(n));
+            }
+        }
+    });
+    std::ofstream out(path, std::ios::binary);
+    out.write(text.data(), std::streamsize(text.size()));
+    return bool(out.flush());
+}
+}  // namespace graph_sdk
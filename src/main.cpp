@@ -1,15 +1,29 @@
 #include <cmath>
 #include <matplot/matplot.h>
 
+#include "../include/layout.h"
+
 std::vector<std::pair<size_t, size_t>> get_edges();
 
-int main() {
+// With a path argument the layout is written there for headless rendering,
+// otherwise matplot draws it with the precomputed coordinates.
+int main(int argc, char** argv) {
     using namespace matplot;
     std::vector<std::pair<size_t, size_t>> edges = {
         {0, 1},   {0, 2},   {0, 3},   {0, 4},   {1, 5},  {1, 6},  {1, 7},
         {1, 8},   {1, 9},   {1, 10},  {1, 11},  {1, 12}, {1, 13}, {1, 14},
         {14, 15}, {14, 16}, {14, 17}, {14, 18}, {14, 19}};
-    digraph(edges);
+    graph_sdk::Adjacency adjacency(20);
+    for (auto [u, v] : edges) adjacency[u].insert(v);
+    graph_sdk::DirectedGraph graph(adjacency);
+    auto layout = graph_sdk::force_directed_layout(
+        graph, 300, 0, graph_sdk::ExecutionPolicy::par());
+    if (argc > 1)
+        return graph_sdk::write_layout(argv[1], graph, layout) ? 0 : 1;
+
+    auto network = digraph(edges);
+    network->x_data(layout.x);
+    network->y_data(layout.y);
 
     show();
     return 0;
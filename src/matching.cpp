@@ -0,0 +1,68 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <vector>
+
+#include "../include/graph.h"
+#include "../include/instrument.h"
+#include "../include/matching.h"
+
+namespace graph_sdk {
+
+namespace {
+template <class Graph>
+std::vector<std::pair<size_t, size_t>> matched_edges(
+    const Graph& graph, const std::vector<BipartiteSide>& side) {
+    std::vector<typename Graph::node_type> mate{};
+    hopcroft_karp(graph, side, mate);
+    std::vector<std::pair<size_t, size_t>> edges{};
+    for (size_t i = 0; i < mate.size(); ++i) {
+        if (side[i] == BipartiteSide::left && mate[i] != Graph::none)
+            edges.emplace_back(i, mate[i]);
+    }
+    return edges;
+}
+}  // namespace
+
+std::vector<std::pair<size_t, size_t>> DirectedGraph::bipartite_matching()
+    const {
+    GRAPH_SDK_RECORD("bipartite_matching");
+    auto attribute = DirectedGraph::cached_attribute();
+    std::vector<BipartiteSide> side(VN_, BipartiteSide::excluded);
+    for (size_t i = 0; i < VN_; ++i) {
+        if ((*attribute)[i] == NodeAttribute::source)
+            side[i] = BipartiteSide::left;
+        else if ((*attribute)[i] == NodeAttribute::sink)
+            side[i] = BipartiteSide::right;
+    }
+    if (CsrGraph32::fits(VN_, EN_))
+        return matched_edges(DirectedGraph::to_csr(), side);
+    return matched_edges(DirectedGraph::to_csr<uint64_t, uint64_t>(), side);
+}
+
+// True when every unit of flow runs source -> left -> right -> sink over
+// edges of capacity 1, the max flow is then a maximum matching plus the
+// direct source -> sink edge. Edges into source or out of sink never carry
+// flow and are skipped.
+bool DiWeightedGraph::unit_bipartite(size_t source, size_t sink,
+                                     std::vector<BipartiteSide>& side) const {
+    if (source >= VN_ || sink >= VN_ || source == sink) return false;
+    side.assign(VN_, BipartiteSide::excluded);
+    for (auto x : adjacency_[source]) {
+        if (x != sink) side[x] = BipartiteSide::left;
+    }
+    for (size_t i = 0; i < VN_; ++i) {
+        if (i == source || adjacency_[i].count(sink) == 0) continue;
+        if (side[i] == BipartiteSide::left) return false;
+        side[i] = BipartiteSide::right;
+    }
+    for (const auto& [key, value] : weighted_edges_) {
+        auto [u, v] = key;
+        if (u == sink || v == source) continue;
+        if (value != 1) return false;
+        if (u == source || v == sink) continue;
+        if (side[u] != BipartiteSide::left || side[v] != BipartiteSide::right)
+            return false;
+    }
+    return true;
+}
+}  // namespace graph_sdk
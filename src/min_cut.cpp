@@ -0,0 +1,114 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <vector>
+
+#include "../include/graph.h"
+#include "../include/instrument.h"
+
+namespace graph_sdk {
+
+// side[v] is 1 for the nodes reachable from source in the residual graph
+int DiWeightedGraph::residual_cut(size_t source, size_t sink,
+                                  std::vector<char>& side,
+                                  const ExecutionPolicy& policy) const {
+    assert(source < VN_ && sink < VN_ && source != sink);
+    auto flow_adjacency = DiWeightedGraph::get_weighted_adjacency();
+    int flow_value =
+        DiWeightedGraph::saturate(source, sink, flow_adjacency, policy);
+
+    side.assign(VN_, 0);
+    side[source] = 1;
+    std::vector<size_t> queue{source};
+    for (size_t head = 0; head < queue.size(); ++head) {
+        for (const auto& [id, value] : flow_adjacency[queue[head]]) {
+            if (side[id] || value <= 0) continue;
+            side[id] = 1;
+            queue.push_back(id);
+        }
+    }
+    return flow_value;
+}
+
+std::pair<int, std::vector<size_t>> DiWeightedGraph::min_cut_partition(
+    size_t source, size_t sink, const ExecutionPolicy& policy) const {
+    GRAPH_SDK_RECORD("min_cut_partition");
+    std::vector<char> side{};
+    int value = DiWeightedGraph::residual_cut(source, sink, side, policy);
+    std::vector<size_t> nodes{};
+    for (size_t i = 0; i < VN_; ++i) {
+        if (side[i]) nodes.push_back(i);
+    }
+    return std::make_pair(value, nodes);
+}
+
+std::pair<int, std::vector<std::pair<size_t, size_t>>> DiWeightedGraph::min_cut(
+    size_t source, size_t sink, const ExecutionPolicy& policy) const {
+    GRAPH_SDK_RECORD("min_cut");
+    std::vector<char> side{};
+    int value = DiWeightedGraph::residual_cut(source, sink, side, policy);
+    std::vector<std::pair<size_t, size_t>> edges{};
+    for (size_t i = 0; i < VN_; ++i) {
+        if (!side[i]) continue;
+        for (auto x : adjacency_[i]) {
+            if (!side[x]) edges.emplace_back(i, x);
+        }
+    }
+    return std::make_pair(value, edges);
+}
+
+// Gusfield: node s is cut from its current parent t, the nodes that end on
+// the side of s and still hang below t move under s. A batch of consecutive
+// nodes is cut speculatively in parallel with the parents known before the
+// batch; while applying them in order a node whose parent has moved in the
+// meantime is cut again, so the tree equals the sequential one.
+CutTree DiWeightedGraph::gomory_hu_tree(const ExecutionPolicy& policy) const {
+    GRAPH_SDK_RECORD("gomory_hu_tree");
+    WeightedEdges capacities{};
+    for (const auto& [key, value] : weighted_edges_) {
+        capacities[key] += value;
+        capacities[std::make_pair(key.second, key.first)] += value;
+    }
+    DiWeightedGraph undirected(capacities);
+    undirected.adjacency_.resize(VN_);
+    undirected.VN_ = VN_;
+
+    struct Cut {
+        size_t sink{};
+        int value{};
+        std::vector<char> side{};
+    };
+    std::vector<size_t> parent(VN_, 0);
+    std::vector<int> weight(VN_, 0);
+    const size_t batch = policy.threads();
+    for (size_t first = 1; first < VN_; first += batch) {
+        const auto last = std::min(VN_, first + batch);
+        std::vector<Cut> cuts(last - first);
+        {
+            GRAPH_SDK_PHASE("speculate");
+            parallel_for(policy, first, last, 1, [&](size_t b, size_t e) {
+                for (size_t s = b; s < e; ++s) {
+                    auto& cut = cuts[s - first];
+                    cut.sink = parent[s];
+                    cut.value = undirected.residual_cut(
+                        s, cut.sink, cut.side, ExecutionPolicy::seq());
+                }
+            });
+        }
+        GRAPH_SDK_PHASE("apply");
+        for (size_t s = first; s < last; ++s) {
+            auto& cut = cuts[s - first];
+            if (cut.sink != parent[s]) {
+                cut.sink = parent[s];
+                cut.value =
+                    undirected.residual_cut(s, cut.sink, cut.side, policy);
+            }
+            weight[s] = cut.value;
+            for (size_t i = s + 1; i < VN_; ++i) {
+                if (cut.side[i] && parent[i] == cut.sink) parent[i] = s;
+            }
+        }
+    }
+    return CutTree(std::move(parent), std::move(weight));
+}
+}  // namespace graph_sdk
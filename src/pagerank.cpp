@@ -0,0 +1,176 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "../include/instrument.h"
+#include "../include/pagerank.h"
+
+namespace graph_sdk {
+
+namespace {
+constexpr size_t grain = 4096;
+
+// four independent partial sums let the loop stay in vector registers,
+// a single accumulator would serialise on the floating point additions
+double l1_distance(const double* a, const double* b, size_t n) {
+    double lane[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (size_t k = 0; k < 4; ++k) lane[k] += std::abs(a[i + k] - b[i + k]);
+    }
+    for (; i < n; ++i) lane[0] += std::abs(a[i] - b[i]);
+    return (lane[0] + lane[1]) + (lane[2] + lane[3]);
+}
+}  // namespace
+
+// The out-degree decides what is a sink: get_attribute() labels a node
+// reached before its own row is scanned as a sink even if it has out-edges.
+PageRank::PageRank(const DirectedGraph& graph) {
+    is_wide_ = !graph.fits_csr32();
+    if (is_wide_)
+        build(wide_, *graph.cached_wide_csr());
+    else
+        build(narrow_, *graph.cached_csr());
+}
+
+template <typename NodeId, typename EdgeId>
+void PageRank::build(Topology<NodeId, EdgeId>& topology,
+                     const CsrGraph<NodeId, EdgeId>& out_edges) {
+    topology.out_edges = out_edges;
+    topology.in_edges = out_edges.reverse();
+    inverse_degree_.assign(out_edges.node_num(), 0.0);
+    for (size_t v = 0; v < out_edges.node_num(); ++v) {
+        if (auto degree = out_edges.degree(v); degree == 0)
+            sinks_.push_back(v);
+        else
+            inverse_degree_[v] = 1.0 / double(degree);
+    }
+}
+
+std::pair<bool, std::vector<double>> PageRank::rank(
+    double damping, double tolerance, size_t max_iterations,
+    const ExecutionPolicy& policy) const {
+    GRAPH_SDK_RECORD("pagerank");
+    return is_wide_
+               ? rank(wide_, damping, tolerance, max_iterations, policy)
+               : rank(narrow_, damping, tolerance, max_iterations, policy);
+}
+
+std::vector<std::vector<std::pair<size_t, double>>> PageRank::personalized(
+    const std::vector<size_t>& seeds, double damping, double epsilon,
+    const ExecutionPolicy& policy) const {
+    GRAPH_SDK_RECORD("personalized_pagerank");
+    return is_wide_ ? personalized(wide_, seeds, damping, epsilon, policy)
+                    : personalized(narrow_, seeds, damping, epsilon, policy);
+}
+
+// Each iteration scales the ranks by the inverse degrees in one contiguous
+// pass, then every node sums the scaled ranks of its in-neighbours. Chunks
+// report their L1 change separately and are added in order, so the result
+// is the same for every policy.
+template <typename NodeId, typename EdgeId>
+std::pair<bool, std::vector<double>> PageRank::rank(
+    const Topology<NodeId, EdgeId>& topology, double damping,
+    double tolerance, size_t max_iterations,
+    const ExecutionPolicy& policy) const {
+    const auto V = node_num();
+    if (V == 0) return std::make_pair(true, std::vector<double>{});
+    const auto& offsets = topology.in_edges.offsets();
+    const auto& targets = topology.in_edges.targets();
+    std::vector<double> rank(V, 1.0 / double(V)), next(V, 0.0);
+    std::vector<double> contribution(V, 0.0);
+    std::vector<double> change((V + grain - 1) / grain, 0.0);
+
+    for (size_t iteration = 0; iteration < max_iterations; ++iteration) {
+        parallel_for(policy, 0, V, grain, [&](size_t b, size_t e) {
+            const double* r = rank.data();
+            const double* inverse = inverse_degree_.data();
+            double* c = contribution.data();
+            for (size_t i = b; i < e; ++i) c[i] = r[i] * inverse[i];
+        });
+        double dangling = 0.0;
+        for (auto x : sinks_) dangling += rank[x];
+        const double base = (1.0 - damping + damping * dangling) / double(V);
+
+        parallel_for(policy, 0, V, grain, [&](size_t b, size_t e) {
+            for (size_t v = b; v < e; ++v) {
+                double sum = 0.0;
+                for (auto k = offsets[v]; k < offsets[v + 1]; ++k)
+                    sum += contribution[targets[k]];
+                next[v] = base + damping * sum;
+            }
+            change[b / grain] =
+                l1_distance(next.data() + b, rank.data() + b, e - b);
+        });
+        rank.swap(next);
+        GRAPH_SDK_COUNT_EDGES(topology.in_edges.edge_num());
+
+        double total = 0.0;
+        for (auto x : change) total += x;
+        if (total < tolerance) return std::make_pair(true, rank);
+    }
+    return std::make_pair(false, rank);
+}
+
+template <typename NodeId, typename EdgeId>
+std::vector<std::vector<std::pair<size_t, double>>> PageRank::personalized(
+    const Topology<NodeId, EdgeId>& topology,
+    const std::vector<size_t>& seeds, double damping, double epsilon,
+    const ExecutionPolicy& policy) const {
+    const auto& out_edges = topology.out_edges;
+    const auto V = node_num();
+    const double teleport = 1.0 - damping;
+    std::vector<std::vector<std::pair<size_t, double>>> result(seeds.size());
+    auto threshold = [&](size_t v) {
+        return epsilon * double(std::max<size_t>(1, out_edges.degree(v)));
+    };
+
+    parallel_for(policy, 0, seeds.size(), 16, [&](size_t b, size_t e) {
+        // scratch shared by the seeds of a chunk, reset through `touched`
+        constexpr uint8_t seen = 1, queued = 2;
+        std::vector<double> estimate(V, 0.0), residual(V, 0.0);
+        std::vector<uint8_t> flags(V, 0);
+        std::vector<NodeId> touched{}, queue{};
+        for (size_t s = b; s < e; ++s) {
+            const auto seed = seeds[s];
+            assert(seed < V);
+            auto receive = [&](size_t v, double mass) {
+                if (!flags[v]) touched.push_back(NodeId(v));
+                flags[v] |= seen;
+                residual[v] += mass;
+                if (!(flags[v] & queued) && residual[v] >= threshold(v)) {
+                    flags[v] |= queued;
+                    queue.push_back(NodeId(v));
+                }
+            };
+            receive(seed, 1.0);
+            for (size_t head = 0; head < queue.size(); ++head) {
+                auto u = queue[head];
+                flags[u] &= uint8_t(~queued);
+                auto mass = residual[u];
+                if (mass < threshold(u)) continue;
+                residual[u] = 0.0;
+                estimate[u] += teleport * mass;
+                if (out_edges.degree(u) == 0) {
+                    receive(seed, damping * mass);
+                    continue;
+                }
+                auto share = damping * mass * inverse_degree_[u];
+                for (auto v : out_edges.neighbours(u)) receive(v, share);
+            }
+
+            std::sort(touched.begin(), touched.end());
+            for (auto v : touched) {
+                if (estimate[v] > 0.0) result[s].emplace_back(v, estimate[v]);
+                estimate[v] = residual[v] = 0.0;
+                flags[v] = 0;
+            }
+            touched.clear();
+            queue.clear();
+        }
+    });
+    return result;
+}
+}  // namespace graph_sdk
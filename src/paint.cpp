@@ -3,38 +3,83 @@
 #include "../include/paint.h"
 
 #include "../include/graph.h"
+#include "../include/instrument.h"
 
 namespace graph_sdk {
 
-std::vector<size_t> extract_sources(const Matrix<int>& di_matrix) {
-    std::vector<size_t> sources{};
-    for (size_t r = 0; r < di_matrix.rows(); ++r) {
-        if (di_matrix.row(r).is_none([](int x) { return x < 0; }) &&
-            !(di_matrix.row(r).is_all(0))) {
-            sources.push_back(r);
-        }
+namespace {
+// rows are tested in parallel, the result keeps the row order
+template <class UnaryPred>
+std::vector<size_t> collect_rows_if(const Matrix<int>& matrix, UnaryPred p,
+                                    const ExecutionPolicy& policy) {
+    std::vector<char> selected(matrix.rows(), 0);
+    GRAPH_SDK_COUNT_CELLS(matrix.rows() * matrix.cols());
+    parallel_for(policy, 0, matrix.rows(), 64, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) selected[r] = p(r) ? 1 : 0;
+    });
+    std::vector<size_t> rows{};
+    for (size_t r = 0; r < matrix.rows(); ++r) {
+        if (selected[r]) rows.push_back(r);
     }
-    return sources;
+    return rows;
 }
 
-std::vector<size_t> extract_sinks(const Matrix<int>& di_matrix) {
-    std::vector<size_t> sinks{};
-    for (size_t r = 0; r < di_matrix.rows(); ++r) {
-        if (di_matrix.row(r).is_none([](int x) { return x > 0; }) &&
-            !(di_matrix.row(r).is_all(0))) {
-            sinks.push_back(r);
-        }
-    }
-    return sinks;
+uint64_t splitmix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t combine(uint64_t h, uint64_t x) { return splitmix(h ^ splitmix(x)); }
+
+size_t distinct(std::vector<uint64_t> colours) {
+    std::sort(colours.begin(), colours.end());
+    return size_t(std::unique(colours.begin(), colours.end()) -
+                  colours.begin());
+}
+}  // namespace
+
+std::vector<size_t> extract_sources(const Matrix<int>& di_matrix,
+                                    const ExecutionPolicy& policy) {
+    return collect_rows_if(
+        di_matrix,
+        [&](size_t r) {
+            return di_matrix.row(r).is_none([](int x) { return x < 0; }) &&
+                   !(di_matrix.row(r).is_all(0));
+        },
+        policy);
+}
+
+std::vector<size_t> extract_sinks(const Matrix<int>& di_matrix,
+                                  const ExecutionPolicy& policy) {
+    return collect_rows_if(
+        di_matrix,
+        [&](size_t r) {
+            return di_matrix.row(r).is_none([](int x) { return x > 0; }) &&
+                   !(di_matrix.row(r).is_all(0));
+        },
+        policy);
 }
 
 Matrix<int> remove_sources(const std::vector<size_t>& sources,
-                           const Matrix<int>& di_matrix) {
+                           const Matrix<int>& di_matrix,
+                           const ExecutionPolicy& policy) {
     auto residual_matrix = di_matrix;
-    for (auto s : sources) {
-        residual_matrix.col_replace_if(s, 0, [](int x) { return x != 0; });
-        residual_matrix.row_replace_if(s, 0, [](int x) { return x != 0; });
-    }
+    GRAPH_SDK_COUNT_CELLS(di_matrix.rows() * di_matrix.cols());
+    std::vector<bool> is_source(di_matrix.rows(), false);
+    for (auto s : sources) is_source[s] = true;
+    parallel_for(
+        policy, 0, residual_matrix.rows(), 64, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r) {
+                if (is_source[r]) {
+                    for (size_t c = 0; c < residual_matrix.cols(); ++c)
+                        residual_matrix(r, c) = 0;
+                } else {
+                    for (auto s : sources) residual_matrix(r, s) = 0;
+                }
+            }
+        });
     return residual_matrix;
 }
 
@@ -157,24 +202,29 @@ void update_edge_color(const std::vector<size_t>& sources,
 }
 
 void paint_once(Matrix<int>& edge_color_matrix, int& max_edge_color,
-                Matrix<int>& curr_matrix) {
-    auto sinks = extract_sinks(curr_matrix);
+                Matrix<int>& curr_matrix, const ExecutionPolicy& policy) {
+    auto sinks = extract_sinks(curr_matrix, policy);
     std::unordered_set<int> label_set{};
     while (!curr_matrix.is_all(0)) {
-        auto sources = extract_sources(curr_matrix);
+        auto sources = extract_sources(curr_matrix, policy);
         update_edge_color(sources, edge_color_matrix, max_edge_color,
                           label_set);
-        curr_matrix = remove_sources(sources, curr_matrix);
+        curr_matrix = remove_sources(sources, curr_matrix, policy);
     }
     update_edge_color(sinks, edge_color_matrix, max_edge_color, label_set);
 }
 
-Matrix<int> generate_description(const Matrix<int>& edge_color_matrix) {
+Matrix<int> generate_description(const Matrix<int>& edge_color_matrix,
+                                 const ExecutionPolicy& policy) {
     auto row_num = edge_color_matrix.rows();
+    GRAPH_SDK_COUNT_CELLS(row_num * edge_color_matrix.cols());
     std::vector<std::vector<int>> result(row_num, std::vector<int>{});
+    parallel_for(policy, 0, row_num, 64, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r)
+            result[r] = extract_node_description(r, edge_color_matrix);
+    });
     size_t max_cols = 0;
     for (auto r = 0; r < row_num; ++r) {
-        result[r] = extract_node_description(r, edge_color_matrix);
         max_cols = (max_cols < result[r].size()) ? result[r].size() : max_cols;
     }
     for (auto r = 0; r < row_num; ++r) {
@@ -184,19 +234,67 @@ Matrix<int> generate_description(const Matrix<int>& edge_color_matrix) {
     return matrix;
 }
 
-Matrix<int> paint_graph(const Matrix<int>& di_matrix) {
+Matrix<int> paint_graph(const Matrix<int>& di_matrix,
+                        const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("paint_graph");
     int max_edge_color = 1;
     auto edge_color_matrix = di_matrix;
     auto curr_matrix = di_matrix;
     bool loop = true;
     while (loop) {
         auto tmp = edge_color_matrix;
-        paint_once(edge_color_matrix, max_edge_color, curr_matrix);
-        generate_description(edge_color_matrix).print();
+        {
+            GRAPH_SDK_PHASE("paint_once");
+            paint_once(edge_color_matrix, max_edge_color, curr_matrix, policy);
+        }
+        {
+            GRAPH_SDK_PHASE("describe");
+            generate_description(edge_color_matrix, policy).print();
+        }
+        GRAPH_SDK_PHASE("transpose");
         loop = (tmp != edge_color_matrix);
         edge_color_matrix = edge_color_matrix.transpose();
         curr_matrix = di_matrix.transpose();
     }
-    return generate_description(edge_color_matrix);
+    return generate_description(edge_color_matrix, policy);
+}
+
+uint64_t refinement_certificate(const DirectedGraph& graph,
+                                const ExecutionPolicy& policy) {
+    GRAPH_SDK_RECORD("refinement_certificate");
+    const auto out_edges = graph.cached_csr();
+    const auto in_edges = out_edges->reverse();
+    const auto V = out_edges->node_num();
+    std::vector<uint64_t> colour(V), next(V);
+    for (size_t v = 0; v < V; ++v)
+        colour[v] = combine(splitmix(out_edges->degree(v)),
+                            in_edges.degree(v));
+    auto classes = distinct(colour);
+    for (size_t round = 0; round < V; ++round) {
+        parallel_for(policy, 0, V, 1024, [&](size_t begin, size_t end) {
+            std::vector<uint64_t> bag{};
+            for (size_t v = begin; v < end; ++v) {
+                auto h = colour[v];
+                for (const auto* edges : {out_edges.get(), &in_edges}) {
+                    bag.clear();
+                    for (auto x : edges->neighbours(v))
+                        bag.push_back(colour[x]);
+                    std::sort(bag.begin(), bag.end());
+                    h = combine(h, bag.size());
+                    for (auto c : bag) h = combine(h, c);
+                }
+                next[v] = h;
+            }
+        });
+        colour.swap(next);
+        // refinement only splits classes, an equal count means stable
+        auto refined = distinct(colour);
+        if (refined == classes) break;
+        classes = refined;
+    }
+    std::sort(colour.begin(), colour.end());
+    auto certificate = combine(V, out_edges->edge_num());
+    for (auto c : colour) certificate = combine(certificate, c);
+    return certificate;
 }
 }  // namespace graph_sdk
@@ -0,0 +1,102 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include "../include/parallel.h"
+
+namespace graph_sdk {
+
+namespace {
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+}  // namespace
+
+ThreadPool::ThreadPool(size_t workers) {
+    workers = std::max<size_t>(workers, 1);
+    for (size_t i = 0; i < workers; ++i)
+        queues_.push_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < workers; ++i)
+        threads_.emplace_back([this, i]() { worker_loop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool(std::thread::hardware_concurrency() > 1
+                               ? std::thread::hardware_concurrency() - 1
+                               : 1);
+    return pool;
+}
+
+void ThreadPool::submit(Task task) {
+    // workers push to their own deque, outside threads spread round robin
+    size_t q = (current_pool == this)
+                   ? current_worker
+                   : next_queue_.fetch_add(1) % queues_.size();
+    // counted before it is visible, so a thief never takes pending_ below
+    // zero; a worker woken early only retries until the push lands
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        pending_.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+        queues_[q]->tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::pop_or_steal(size_t self, Task& task) {
+    const auto n = queues_.size();
+    {
+        auto& own = *queues_[self % n];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            pending_.fetch_sub(1);
+            return true;
+        }
+    }
+    for (size_t i = 1; i < n; ++i) {
+        auto& victim = *queues_[(self + i) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::try_run_one() {
+    Task task{};
+    auto self = (current_pool == this) ? current_worker : 0;
+    if (!pop_or_steal(self, task)) return false;
+    task();
+    return true;
+}
+
+void ThreadPool::worker_loop(size_t self) {
+    current_pool = this;
+    current_worker = self;
+    while (true) {
+        Task task{};
+        if (pop_or_steal(self, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [&]() { return stop_ || pending_.load() > 0; });
+        if (stop_ && pending_.load() == 0) return;
+    }
+}
+
+}  // namespace graph_sdk
@@ -0,0 +1,68 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+
+#include "../include/path_count.h"
+
+namespace graph_sdk {
+
+BigUint::BigUint(uint64_t value) {
+    for (; value; value >>= 32) limbs_.push_back(uint32_t(value));
+}
+
+BigUint& BigUint::operator+=(const BigUint& other) {
+    if (limbs_.size() < other.limbs_.size())
+        limbs_.resize(other.limbs_.size(), 0);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < limbs_.size(); ++i) {
+        if (i >= other.limbs_.size() && carry == 0) break;
+        carry += limbs_[i];
+        if (i < other.limbs_.size()) carry += other.limbs_[i];
+        limbs_[i] = uint32_t(carry);
+        carry >>= 32;
+    }
+    if (carry) limbs_.push_back(uint32_t(carry));
+    return *this;
+}
+
+BigUint BigUint::operator*(const BigUint& other) const {
+    BigUint product{};
+    if (is_zero() || other.is_zero()) return product;
+    product.limbs_.assign(limbs_.size() + other.limbs_.size(), 0);
+    for (size_t i = 0; i < limbs_.size(); ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < other.limbs_.size(); ++j) {
+            carry += uint64_t(limbs_[i]) * other.limbs_[j] +
+                     product.limbs_[i + j];
+            product.limbs_[i + j] = uint32_t(carry);
+            carry >>= 32;
+        }
+        product.limbs_[i + other.limbs_.size()] = uint32_t(carry);
+    }
+    while (!product.limbs_.empty() && product.limbs_.back() == 0)
+        product.limbs_.pop_back();
+    return product;
+}
+
+std::string BigUint::to_string() const {
+    if (is_zero()) return "0";
+    // peel off nine decimal digits at a time
+    auto rest = limbs_;
+    std::string digits{};
+    while (!rest.empty()) {
+        uint64_t remainder = 0;
+        for (auto i = rest.size(); i-- > 0;) {
+            auto current = (remainder << 32) | rest[i];
+            rest[i] = uint32_t(current / 1000000000);
+            remainder = current % 1000000000;
+        }
+        while (!rest.empty() && rest.back() == 0) rest.pop_back();
+        for (int k = 0; k < 9 && (remainder || !rest.empty()); ++k) {
+            digits.push_back(char('0' + remainder % 10));
+            remainder /= 10;
+        }
+    }
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+}  // namespace graph_sdk
@@ -0,0 +1,254 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <numeric>
+#include <utility>
+
+#include "../include/graph.h"
+
+namespace graph_sdk {
+
+namespace {
+
+// neighbours regardless of direction, without duplicates
+std::vector<std::vector<size_t>> undirected_adjacency(
+    const Adjacency& adjacency) {
+    std::vector<std::vector<size_t>> undirected(adjacency.size());
+    for (size_t i = 0; i < adjacency.size(); ++i) {
+        for (auto x : adjacency[i]) {
+            if (x == i) continue;
+            undirected[i].push_back(x);
+            undirected[x].push_back(i);
+        }
+    }
+    for (auto& x : undirected) {
+        std::sort(x.begin(), x.end());
+        x.erase(std::unique(x.begin(), x.end()), x.end());
+    }
+    return undirected;
+}
+
+// breadth first levels from start, returns the last visited node
+size_t bfs_farthest(const std::vector<std::vector<size_t>>& undirected,
+                    size_t start, std::vector<size_t>& level) {
+    std::fill(level.begin(), level.end(), SIZE_MAX);
+    std::deque<size_t> queue{start};
+    level[start] = 0;
+    size_t last = start;
+    while (!queue.empty()) {
+        auto curr = queue.front();
+        queue.pop_front();
+        last = curr;
+        for (auto x : undirected[curr]) {
+            if (level[x] != SIZE_MAX) continue;
+            level[x] = level[curr] + 1;
+            queue.push_back(x);
+        }
+    }
+    return last;
+}
+
+// bucket queue keyed by small integer scores, O(1) increment/decrement
+class UnitHeap {
+   private:
+    static constexpr size_t none = SIZE_MAX;
+    std::vector<size_t> key_{};
+    std::vector<size_t> prev_{};
+    std::vector<size_t> next_{};
+    std::vector<size_t> head_{};
+    std::vector<bool> removed_{};
+    size_t top_{};
+
+    void unlink(size_t v) {
+        if (prev_[v] != none)
+            next_[prev_[v]] = next_[v];
+        else
+            head_[key_[v]] = next_[v];
+        if (next_[v] != none) prev_[next_[v]] = prev_[v];
+    }
+
+    void link(size_t v) {
+        if (key_[v] >= head_.size()) head_.resize(key_[v] + 1, none);
+        prev_[v] = none;
+        next_[v] = head_[key_[v]];
+        if (next_[v] != none) prev_[next_[v]] = v;
+        head_[key_[v]] = v;
+        top_ = std::max(top_, key_[v]);
+    }
+
+   public:
+    explicit UnitHeap(size_t n)
+        : key_(n, 0),
+          prev_(n, none),
+          next_(n, none),
+          head_(1, none),
+          removed_(n, false) {
+        // descending insertion keeps smaller ids at the bucket front
+        for (size_t v = n; v-- > 0;) link(v);
+    }
+
+    void increment(size_t v) {
+        if (removed_[v]) return;
+        unlink(v);
+        key_[v] += 1;
+        link(v);
+    }
+
+    void decrement(size_t v) {
+        if (removed_[v] || key_[v] == 0) return;
+        unlink(v);
+        key_[v] -= 1;
+        link(v);
+    }
+
+    void remove(size_t v) {
+        if (removed_[v]) return;
+        unlink(v);
+        removed_[v] = true;
+    }
+
+    size_t pop_max() {
+        while (top_ > 0 && head_[top_] == none) --top_;
+        auto v = head_[top_];
+        assert(v != none);
+        remove(v);
+        return v;
+    }
+};
+}  // namespace
+
+std::vector<size_t> DirectedGraph::degree_order() const {
+    std::vector<size_t> degree(VN_, 0);
+    for (size_t i = 0; i < VN_; ++i) {
+        degree[i] += adjacency_[i].size();
+        for (auto x : adjacency_[i]) degree[x] += 1;
+    }
+    std::vector<size_t> order(VN_);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return degree[a] > degree[b];
+    });
+    return order;
+}
+
+std::vector<size_t> DirectedGraph::rcm_order() const {
+    auto undirected = undirected_adjacency(adjacency_);
+    std::vector<size_t> order{};
+    order.reserve(VN_);
+    std::vector<bool> visited(VN_, false);
+    std::vector<size_t> level(VN_);
+
+    std::vector<size_t> by_degree(VN_);
+    std::iota(by_degree.begin(), by_degree.end(), 0);
+    std::stable_sort(by_degree.begin(), by_degree.end(),
+                     [&](size_t a, size_t b) {
+                         return undirected[a].size() < undirected[b].size();
+                     });
+
+    for (auto start : by_degree) {
+        if (visited[start]) continue;
+        // pseudo-peripheral start: the far end of a BFS from a low degree node
+        start = bfs_farthest(undirected, start, level);
+
+        size_t head = order.size();
+        order.push_back(start);
+        visited[start] = true;
+        while (head < order.size()) {
+            auto curr = order[head++];
+            auto first = order.size();
+            for (auto x : undirected[curr]) {
+                if (visited[x]) continue;
+                visited[x] = true;
+                order.push_back(x);
+            }
+            std::stable_sort(order.begin() + first, order.end(),
+                             [&](size_t a, size_t b) {
+                                 return undirected[a].size() <
+                                        undirected[b].size();
+                             });
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+std::vector<size_t> DirectedGraph::gorder_order(size_t window) const {
+    std::vector<std::vector<size_t>> in_adjacency(VN_);
+    for (size_t i = 0; i < VN_; ++i) {
+        for (auto x : adjacency_[i]) in_adjacency[x].push_back(i);
+    }
+    // siblings through very large hubs add little locality and cost O(deg^2)
+    const auto hub = static_cast<size_t>(std::sqrt(static_cast<double>(VN_)));
+
+    UnitHeap heap(VN_);
+    auto update = [&](size_t v, bool enter) {
+        auto touch = [&](size_t u) {
+            enter ? heap.increment(u) : heap.decrement(u);
+        };
+        for (auto u : adjacency_[v]) touch(u);
+        for (auto u : in_adjacency[v]) {
+            touch(u);
+            if (adjacency_[u].size() > hub) continue;
+            for (auto w : adjacency_[u])
+                if (w != v) touch(w);
+        }
+    };
+
+    std::vector<size_t> order{};
+    order.reserve(VN_);
+    if (VN_ == 0) return order;
+
+    auto first = std::max_element(
+        in_adjacency.begin(), in_adjacency.end(),
+        [](const auto& a, const auto& b) { return a.size() < b.size(); });
+    auto start = static_cast<size_t>(first - in_adjacency.begin());
+    heap.remove(start);
+    order.push_back(start);
+    update(start, true);
+
+    while (order.size() < VN_) {
+        if (order.size() > window)
+            update(order[order.size() - window - 1], false);
+        auto v = heap.pop_max();
+        order.push_back(v);
+        update(v, true);
+    }
+    return order;
+}
+
+std::vector<size_t> DirectedGraph::compute_ordering(Ordering ordering) const {
+    switch (ordering) {
+        case Ordering::degree:
+            return DirectedGraph::degree_order();
+        case Ordering::rcm:
+            return DirectedGraph::rcm_order();
+        case Ordering::gorder:
+            return DirectedGraph::gorder_order(5);
+    }
+    return {};
+}
+
+void DirectedGraph::relabel(const std::vector<size_t>& inverse) {
+    assert(inverse.size() == VN_);
+    ++version_;
+    Adjacency adjacency(VN_);
+    for (size_t i = 0; i < VN_; ++i) {
+        auto& row = adjacency[inverse[i]];
+        for (auto x : adjacency_[i]) row.insert(row.end(), inverse[x]);
+    }
+    adjacency_ = std::move(adjacency);
+}
+
+std::pair<std::vector<size_t>, std::vector<size_t>> DirectedGraph::reorder(
+    Ordering ordering) {
+    auto permutation = DirectedGraph::compute_ordering(ordering);
+    std::vector<size_t> inverse(permutation.size());
+    for (size_t i = 0; i < permutation.size(); ++i) inverse[permutation[i]] = i;
+    DirectedGraph::relabel(inverse);
+    return std::make_pair(permutation, inverse);
+}
+}  // namespace graph_sdk
@@ -0,0 +1,118 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <vector>
+
+#include "../include/bit_matrix.h"
+#include "../include/graph.h"
+#include "../include/instrument.h"
+
+namespace graph_sdk {
+
+namespace {
+// descendants of every node restricted to columns [first, first + cols()),
+// levels are processed from the sinks up and each level in parallel
+template <class Graph>
+void closure_block(const Graph& csr, const TopologicalLevels& levels,
+                   size_t first, BitMatrix& block,
+                   const ExecutionPolicy& policy) {
+    const auto last = first + block.cols();
+    for (size_t l = levels.level_num(); l-- > 0;) {
+        auto nodes = levels.level(l);
+        parallel_for(policy, 0, nodes.size(), 64, [&](size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                auto v = nodes[i];
+                for (auto w : csr.neighbours(v)) {
+                    if (w >= first && w < last) block.set(v, w - first);
+                    block.row_or(v, w);
+                }
+                GRAPH_SDK_COUNT_EDGES(csr.degree(v));
+            }
+        });
+    }
+}
+
+template <class Graph>
+std::pair<bool, BitMatrix> descendants(const Graph& csr,
+                                       const ExecutionPolicy& policy) {
+    auto levels = topological_levels(csr, policy);
+    if (!levels.is_dag()) return std::make_pair(false, BitMatrix{});
+
+    const auto V = csr.node_num();
+    BitMatrix closure(V, V);
+    closure_block(csr, levels, 0, closure, policy);
+    return std::make_pair(true, closure);
+}
+
+// An edge u -> w is redundant when w descends from another successor of u.
+// Columns are handled in blocks so the scratch stays V * block / 8 bytes.
+// kept[e] belongs to csr.targets()[e].
+template <class Graph>
+std::pair<bool, std::vector<char>> kept_edges(const Graph& csr,
+                                              const ExecutionPolicy& policy) {
+    auto levels = topological_levels(csr, policy);
+    if (!levels.is_dag()) return std::make_pair(false, std::vector<char>{});
+
+    const auto V = csr.node_num();
+    const size_t block_cols = 8192;
+    std::vector<char> kept(csr.edge_num(), 1);
+    for (size_t first = 0; first < V; first += block_cols) {
+        BitMatrix block(V, std::min(block_cols, V - first));
+        {
+            GRAPH_SDK_PHASE("closure");
+            closure_block(csr, levels, first, block, policy);
+        }
+        GRAPH_SDK_PHASE("reduce");
+        const auto last = first + block.cols();
+        parallel_for(policy, 0, V, 64, [&](size_t b, size_t e) {
+            std::vector<uint64_t> covered(block.words());
+            for (size_t u = b; u < e; ++u) {
+                std::fill(covered.begin(), covered.end(), 0);
+                for (auto w : csr.neighbours(u)) {
+                    const auto* row = block.row(w);
+                    for (size_t k = 0; k < covered.size(); ++k)
+                        covered[k] |= row[k];
+                }
+                for (auto edge = csr.offsets()[u]; edge < csr.offsets()[u + 1];
+                     ++edge) {
+                    size_t w = csr.targets()[edge];
+                    if (w < first || w >= last) continue;
+                    if ((covered[(w - first) / 64] >> ((w - first) % 64)) & 1)
+                        kept[edge] = 0;
+                }
+            }
+        });
+    }
+    return std::make_pair(true, kept);
+}
+}  // namespace
+
+std::pair<bool, BitMatrix> DirectedGraph::transitive_closure(
+    const ExecutionPolicy& policy) const {
+    GRAPH_SDK_RECORD("transitive_closure");
+    if (fits_csr32()) return descendants(DirectedGraph::to_csr(), policy);
+    return descendants(DirectedGraph::to_csr<uint64_t, uint64_t>(), policy);
+}
+
+std::pair<bool, DirectedGraph> DirectedGraph::transitive_reduction(
+    const ExecutionPolicy& policy) const {
+    GRAPH_SDK_RECORD("transitive_reduction");
+    auto [is_dag, kept] =
+        fits_csr32() ? kept_edges(DirectedGraph::to_csr(), policy)
+                     : kept_edges(DirectedGraph::to_csr<uint64_t, uint64_t>(),
+                                  policy);
+    if (!is_dag) return std::make_pair(false, DirectedGraph{});
+
+    // the rows of adjacency_ list the edges in csr order
+    DirectedGraph reduction(VN_);
+    size_t edge = 0;
+    for (size_t u = 0; u < VN_; ++u) {
+        for (auto w : adjacency_[u]) {
+            if (!kept[edge++]) continue;
+            reduction.adjacency_[u].insert(reduction.adjacency_[u].end(), w);
+            reduction.EN_ += 1;
+        }
+    }
+    return std::make_pair(true, reduction);
+}
+}  // namespace graph_sdk
@@ -0,0 +1,180 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <thread>
+
+#include "../include/instrument.h"
+#include "../include/versioned_graph.h"
+
+namespace graph_sdk {
+
+EpochDomain::EpochDomain(size_t slots)
+    : slots_(new Slot[std::max<size_t>(slots, 1)]),
+      slot_num_(std::max<size_t>(slots, 1)) {}
+
+size_t EpochDomain::enter() {
+    const auto start = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    while (true) {
+        for (size_t k = 0; k < slot_num_; ++k) {
+            auto& slot = slots_[(start + k) % slot_num_];
+            bool expected = false;
+            if (slot.used.load(std::memory_order_relaxed) ||
+                !slot.used.compare_exchange_strong(expected, true))
+                continue;
+            // seq_cst: the announcement is visible before the caller reads
+            // the shared pointer
+            slot.epoch.store(global_.load());
+            return (start + k) % slot_num_;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void EpochDomain::leave(size_t slot) {
+    slots_[slot].epoch.store(0, std::memory_order_release);
+    slots_[slot].used.store(false, std::memory_order_release);
+}
+
+uint64_t EpochDomain::retire_epoch() { return global_.fetch_add(1); }
+
+uint64_t EpochDomain::min_active() const {
+    auto result = std::numeric_limits<uint64_t>::max();
+    for (size_t i = 0; i < slot_num_; ++i) {
+        auto epoch = slots_[i].epoch.load();
+        if (epoch != 0) result = std::min(result, epoch);
+    }
+    return result;
+}
+
+VersionedGraph::VersionedGraph(const DirectedGraph& graph, size_t reader_slots)
+    : epochs_(reader_slots) {
+    auto csr = graph.to_csr<size_t, size_t>();
+    auto version = std::make_unique<Version>();
+    version->node_num = csr.node_num();
+    version->edge_num = csr.edge_num();
+    for (size_t v = 0; v < csr.node_num(); ++v) {
+        if (v % page_size == 0)
+            version->pages.push_back(std::make_shared<Page>());
+        auto row = csr.neighbours(v);
+        version->pages.back()->push_back(
+            row.empty() ? empty_row_
+                        : std::make_shared<Row>(row.begin(), row.end()));
+    }
+    current_.store(version.release());
+}
+
+VersionedGraph::~VersionedGraph() {
+    for (auto& x : retired_) delete x.version;
+    delete current_.load();
+}
+
+// the next version starts as a copy of the page table of the current one
+void VersionedGraph::begin_pending() {
+    if (pending_) return;
+    pending_ = std::make_unique<Version>(*current_.load());
+    fresh_pages_.assign(pending_->pages.size(), 0);
+    fresh_rows_.clear();
+}
+
+VersionedGraph::Row& VersionedGraph::writable_row(size_t v) {
+    begin_pending();
+    auto p = v / page_size;
+    if (!fresh_pages_[p]) {
+        pending_->pages[p] = std::make_shared<Page>(*pending_->pages[p]);
+        fresh_pages_[p] = 1;
+    }
+    auto& row = (*pending_->pages[p])[v % page_size];
+    if (fresh_rows_.insert(v).second) row = std::make_shared<Row>(*row);
+    return *row;
+}
+
+void VersionedGraph::grow(size_t node_num) {
+    begin_pending();
+    auto& pages = pending_->pages;
+    for (auto v = pending_->node_num; v < node_num; ++v) {
+        auto p = v / page_size;
+        if (p == pages.size()) {
+            pages.push_back(std::make_shared<Page>());
+            fresh_pages_.push_back(1);
+        } else if (!fresh_pages_[p]) {
+            pages[p] = std::make_shared<Page>(*pages[p]);
+            fresh_pages_[p] = 1;
+        }
+        pages[p]->push_back(empty_row_);
+    }
+    pending_->node_num = std::max(pending_->node_num, node_num);
+}
+
+bool VersionedGraph::add_edge(std::pair<size_t, size_t> arrow) {
+    std::lock_guard<std::mutex> lock(writer_);
+    grow(std::max(arrow.first, arrow.second) + 1);
+    const auto& current = *(*pending_->pages[arrow.first / page_size])
+        [arrow.first % page_size];
+    if (std::binary_search(current.begin(), current.end(), arrow.second))
+        return false;
+    auto& row = writable_row(arrow.first);
+    row.insert(std::lower_bound(row.begin(), row.end(), arrow.second),
+               arrow.second);
+    pending_->edge_num += 1;
+    return true;
+}
+
+bool VersionedGraph::remove_edge(std::pair<size_t, size_t> arrow) {
+    std::lock_guard<std::mutex> lock(writer_);
+    const auto* version = pending_ ? pending_.get() : current_.load();
+    if (arrow.first >= version->node_num) return false;
+    const auto& current = *(*version->pages[arrow.first / page_size])
+        [arrow.first % page_size];
+    if (!std::binary_search(current.begin(), current.end(), arrow.second))
+        return false;
+    auto& row = writable_row(arrow.first);
+    row.erase(std::lower_bound(row.begin(), row.end(), arrow.second));
+    pending_->edge_num -= 1;
+    return true;
+}
+
+size_t VersionedGraph::commit() {
+    std::lock_guard<std::mutex> lock(writer_);
+    if (!pending_) return current_.load()->id;
+    GRAPH_SDK_RECORD("versioned_graph_commit");
+    pending_->id = current_.load()->id + 1;
+    auto id = pending_->id;
+    const auto* old = current_.exchange(pending_.release());
+    retired_.push_back({epochs_.retire_epoch(), old});
+    reclaim();
+    return id;
+}
+
+void VersionedGraph::reclaim() {
+    const auto active = epochs_.min_active();
+    auto kept = std::remove_if(retired_.begin(), retired_.end(),
+                               [&](const Retired& x) {
+                                   if (x.epoch >= active) return false;
+                                   delete x.version;
+                                   return true;
+                               });
+    retired_.erase(kept, retired_.end());
+}
+
+VersionedGraph::Snapshot VersionedGraph::snapshot() const {
+    auto slot = epochs_.enter();
+    return Snapshot(current_.load(), &epochs_, slot);
+}
+
+bool VersionedGraph::Snapshot::has_edge(size_t u, size_t v) const {
+    if (u >= node_num()) return false;
+    auto row = neighbours(u);
+    return std::binary_search(row.begin(), row.end(), v);
+}
+
+DirectedGraph VersionedGraph::Snapshot::to_graph() const {
+    Adjacency adjacency(node_num());
+    for (size_t v = 0; v < node_num(); ++v) {
+        for (auto x : neighbours(v))
+            adjacency[v].insert(adjacency[v].end(), x);
+    }
+    return DirectedGraph(adjacency);
+}
+}  // namespace graph_sdk
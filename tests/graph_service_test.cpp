@@ -0,0 +1,218 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+// Pipelined requests on a freshly committed version, all needing the
+// same derived results, must neither deadlock nor disagree, and every
+// reply must match the answer computed on the graph directly.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "../include/graph_service.h"
+
+using namespace graph_sdk;
+
+namespace {
+std::string frame(uint32_t tag, Opcode opcode,
+                  std::initializer_list<uint64_t> arguments) {
+    std::string request{};
+    for (size_t i = 0; i < 4; ++i) request.push_back(char(tag >> (8 * i)));
+    request.push_back(char(opcode));
+    for (auto x : arguments) {
+        for (size_t i = 0; i < 8; ++i) request.push_back(char(x >> (8 * i)));
+    }
+    return request;
+}
+
+uint64_t field(const std::string& reply, size_t at, size_t bytes) {
+    uint64_t x = 0;
+    for (size_t i = 0; i < bytes; ++i)
+        x |= uint64_t(uint8_t(reply[at + i])) << (8 * i);
+    return x;
+}
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (condition) return;
+    std::fprintf(stderr, "FAILED: %s\n", what);
+    ++failures;
+}
+
+// Edges into the lower half of the nodes only come from smaller nodes, so
+// that half is acyclic and has topological levels; the upper half is
+// mostly one component.
+std::pair<size_t, size_t> add_random_edge(Adjacency& adjacency,
+                                          std::mt19937& rng) {
+    const auto V = adjacency.size();
+    size_t a = rng() % V, b = rng() % V;
+    if (a == b) b = (b + 1) % V;
+    if (b < V / 2 && a > b) std::swap(a, b);
+    adjacency[a].insert(b);
+    return {a, b};
+}
+
+// the node pair asked about by a two argument request
+std::pair<size_t, size_t> pair_of(uint32_t tag, size_t V) {
+    return {size_t(tag) * 7919 % V, (size_t(tag) * 104729 + 1) % V};
+}
+
+WeightedEdges unit_capacities(const Adjacency& adjacency) {
+    WeightedEdges edges{};
+    for (size_t v = 0; v < adjacency.size(); ++v) {
+        for (auto x : adjacency[v]) edges[{v, x}] = 1;
+    }
+    return edges;
+}
+
+// two disjoint paths and a direct edge from 0 to 3, and a dead end
+void max_flow_round_trip() {
+    Adjacency adjacency{{1, 2, 3}, {3}, {3}, {}, {0}};
+    GraphService service(DirectedGraph(adjacency), ExecutionPolicy::seq());
+    auto reply = service.handle(frame(1, Opcode::max_flow, {0, 3}));
+    check(reply.size() == 17 && Status(uint8_t(reply[8])) == Status::ok,
+          "max_flow status");
+    check(field(reply, 9, 8) == 3, "max_flow value");
+    reply = service.handle(frame(2, Opcode::max_flow, {3, 0}));
+    check(field(reply, 9, 8) == 0, "max_flow against the edges");
+    reply = service.handle(frame(3, Opcode::max_flow, {3, 3}));
+    check(Status(uint8_t(reply[8])) == Status::bad_request,
+          "max_flow from a node to itself");
+}
+}  // namespace
+
+int main() {
+    constexpr size_t V = 20000, requests = 96;
+    std::mt19937 rng(7);
+    Adjacency adjacency(V);
+    for (size_t k = 0; k < 4 * V; ++k) add_random_edge(adjacency, rng);
+    GraphService service(DirectedGraph(adjacency), ExecutionPolicy::par(4));
+    RequestExecutor executor(service, 4);
+
+    for (size_t round = 0; round < 3; ++round) {
+        // a fresh version, nothing derived for it yet
+        const auto [u, v] = add_random_edge(adjacency, rng);
+        service.handle(frame(0, Opcode::add_edge, {u, v}));
+        service.handle(frame(0, Opcode::commit, {}));
+        const DirectedGraph graph(adjacency);
+        Workspace workspace{};
+        std::vector<size_t> expected{};
+        graph.extract_scc(workspace, expected);
+        const auto levels = graph.topological_levels();
+        std::vector<size_t> level(V, V);
+        for (size_t l = 0; l < levels.level_num(); ++l) {
+            for (auto x : levels.level(l)) level[x] = l;
+        }
+        const auto csr = graph.to_csr();
+        const DiWeightedGraph network(unit_capacities(adjacency));
+
+        std::mutex mutex{};
+        std::condition_variable done{};
+        std::map<uint32_t, std::string> replies{};
+        for (uint32_t tag = 0; tag < requests; ++tag) {
+            const auto [s, t] = pair_of(tag, V);
+            std::string request{};
+            switch (tag % 6) {
+                case 0:
+                    request = frame(tag, Opcode::scc_id, {s});
+                    break;
+                case 1:
+                    request = frame(tag, Opcode::topological_level, {s});
+                    break;
+                case 2:
+                    request = frame(tag, Opcode::certificate, {});
+                    break;
+                case 3:
+                    request = frame(tag, Opcode::reachable, {s, t});
+                    break;
+                case 4:
+                    request = frame(tag, Opcode::shortest_path, {s, t});
+                    break;
+                default:
+                    request = frame(tag, Opcode::max_flow, {s, t});
+            }
+            executor.submit(std::move(request), [&](std::string reply) {
+                std::lock_guard<std::mutex> lock(mutex);
+                replies[uint32_t(field(reply, 4, 4))] = std::move(reply);
+                done.notify_one();
+            });
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!done.wait_for(lock, std::chrono::seconds(60),
+                           [&]() { return replies.size() == requests; })) {
+            std::fprintf(stderr, "FAILED: pipelined requests hang\n");
+            std::_Exit(1);
+        }
+        uint64_t certificate = 0;
+        for (uint32_t tag = 0; tag < requests; ++tag) {
+            const auto& reply = replies[tag];
+            const auto status = Status(uint8_t(reply[8]));
+            const auto [s, t] = pair_of(tag, V);
+            if (tag % 6 == 0) {
+                check(status == Status::ok, "scc_id status");
+                check(field(reply, 9, 8) == expected[s],
+                      "scc_id label");
+            } else if (tag % 6 == 1) {
+                if (level[s] == V) {
+                    check(status == Status::no_result,
+                          "topological_level of a leftover node");
+                } else {
+                    check(status == Status::ok, "topological_level status");
+                    check(field(reply, 9, 8) == level[s],
+                          "topological_level value");
+                }
+            } else if (tag % 6 == 2) {
+                check(status == Status::ok, "certificate status");
+                if (tag == 2) certificate = field(reply, 9, 8);
+                check(field(reply, 9, 8) == certificate,
+                      "certificate agrees");
+            } else if (tag % 6 == 3) {
+                const auto distance = breadth_first_distances(csr, s);
+                check(status == Status::ok, "reachable status");
+                check(field(reply, 9, 1) ==
+                          (distance[t] != std::numeric_limits<uint32_t>::max()),
+                      "reachable value");
+            } else if (tag % 6 == 4) {
+                const auto distance = breadth_first_distances(csr, s);
+                if (distance[t] == std::numeric_limits<uint32_t>::max()) {
+                    check(status == Status::no_result,
+                          "shortest_path to an unreachable node");
+                    continue;
+                }
+                check(status == Status::ok, "shortest_path status");
+                const auto n = field(reply, 9, 4);
+                check(n == distance[t] + 1 && reply.size() == 13 + 8 * n,
+                      "shortest_path length");
+                if (n != distance[t] + 1 || reply.size() != 13 + 8 * n)
+                    continue;
+                check(field(reply, 13, 8) == s &&
+                          field(reply, 13 + 8 * (n - 1), 8) == t,
+                      "shortest_path ends");
+                for (size_t i = 0; i + 1 < n; ++i) {
+                    check(adjacency[field(reply, 13 + 8 * i, 8)].count(
+                              field(reply, 21 + 8 * i, 8)) == 1,
+                          "shortest_path edge");
+                }
+            } else if (s == t) {
+                check(status == Status::bad_request, "max_flow of a node");
+            } else {
+                // nodes without any edge are not in the network
+                const auto nodes = network.cached_csr()->node_num();
+                check(status == Status::ok, "max_flow status");
+                check(int64_t(field(reply, 9, 8)) ==
+                          (s < nodes && t < nodes ? network.max_flow(s, t) : 0),
+                      "max_flow value");
+            }
+        }
+    }
+    max_flow_round_trip();
+    if (failures == 0) std::printf("graph_service_test passed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+// Copyright (c) 2024 Xuemei Wang. All rights reserved.
+
+// graphd <socket> <graph file> [dot|graphml|json]
+// Loads the graph once and answers GraphService requests on a Unix domain
+// socket. Every connection has a reader thread which decodes frames and
+// hands each request to the request threads, so a slow query does not
+// hold back the requests pipelined behind it.
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "../include/graph_io.h"
+#include "../include/graph_service.h"
+
+using namespace graph_sdk;
+
+namespace {
+// protects requests from unbounded allocation
+constexpr uint32_t max_frame = 1 << 16;
+
+struct Connection {
+    int fd;
+    std::mutex write_mutex{};
+
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { close(fd); }
+};
+
+// Connections whose reader thread may still submit requests. The reader
+// threads are detached, stop() ends them before the executor they submit
+// to goes away.
+class Readers {
+   private:
+    std::mutex mutex_{};
+    std::condition_variable idle_{};
+    std::set<int> fds_{};
+
+   public:
+    void add(int fd) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fds_.insert(fd);
+    }
+
+    void remove(int fd) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fds_.erase(fd);
+        idle_.notify_all();
+    }
+
+    void stop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (auto fd : fds_) shutdown(fd, SHUT_RD);
+        idle_.wait(lock, [&]() { return fds_.empty(); });
+    }
+};
+
+bool read_exact(int fd, char* data, size_t n) {
+    while (n > 0) {
+        auto k = read(fd, data, n);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        data += k;
+        n -= size_t(k);
+    }
+    return true;
+}
+
+bool write_exact(int fd, const char* data, size_t n) {
+    while (n > 0) {
+        auto k = send(fd, data, n, MSG_NOSIGNAL);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        data += k;
+        n -= size_t(k);
+    }
+    return true;
+}
+
+void serve(RequestExecutor& executor, Readers& readers,
+           std::shared_ptr<Connection> connection) {
+    for (;;) {
+        unsigned char header[4];
+        if (!read_exact(connection->fd, reinterpret_cast<char*>(header), 4))
+            break;
+        const uint32_t size = header[0] | (header[1] << 8) |
+                              (header[2] << 16) | (uint32_t(header[3]) << 24);
+        if (size > max_frame) break;
+        std::string request(size, '\0');
+        if (!read_exact(connection->fd, request.data(), size)) break;
+        executor.submit(std::move(request), [connection](std::string reply) {
+            std::lock_guard<std::mutex> lock(connection->write_mutex);
+            write_exact(connection->fd, reply.data(), reply.size());
+        });
+    }
+    // the fd stays open until the connection is released, so it cannot be
+    // reused while registered
+    readers.remove(connection->fd);
+    // replies still in flight keep the connection open until they are sent
+    shutdown(connection->fd, SHUT_RD);
+}
+
+GraphFormat parse_format(const std::string& name, bool& ok) {
+    ok = true;
+    if (name == "dot") return GraphFormat::dot;
+    if (name == "graphml") return GraphFormat::graphml;
+    if (name == "json") return GraphFormat::json;
+    ok = false;
+    return GraphFormat::dot;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <socket> <graph> [dot|graphml|json]\n",
+                     argv[0]);
+        return 2;
+    }
+    bool ok = true;
+    auto format = parse_format(argc > 3 ? argv[3] : "dot", ok);
+    if (!ok) {
+        std::fprintf(stderr, "unknown format %s\n", argv[3]);
+        return 2;
+    }
+    auto [loaded, graph] = read_graph(std::string(argv[2]), format);
+    if (!loaded) {
+        std::fprintf(stderr, "cannot read %s\n", argv[2]);
+        return 1;
+    }
+    // outlives the executor, the readers' last steps may still touch it
+    Readers readers{};
+    GraphService service(graph, ExecutionPolicy::par());
+    RequestExecutor executor(
+        service, std::max<unsigned>(std::thread::hardware_concurrency(), 2));
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (std::strlen(argv[1]) >= sizeof(address.sun_path)) {
+        std::fprintf(stderr, "socket path too long\n");
+        return 2;
+    }
+    std::strcpy(address.sun_path, argv[1]);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(argv[1]);
+    if (listener < 0 ||
+        bind(listener, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) < 0 ||
+        listen(listener, 64) < 0) {
+        std::perror("graphd");
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    for (;;) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            std::perror("accept");
+            break;
+        }
+        readers.add(fd);
+        std::thread(serve, std::ref(executor), std::ref(readers),
+                    std::make_shared<Connection>(fd))
+            .detach();
+    }
+    close(listener);
+    // no reader may outlive the executor and the service
+    readers.stop();
+    return 0;
+}